@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Calibration report for L1simulate --estimate.
+
+Runs every header/Test_cases/N_* set, trace_files/app1_test and a few
+synthetic workloads under the four cache configurations of
+regression_test.py, both through the cycle model and through the fast
+estimate, and reports how far the estimate is from the cycle model.
+
+Compared per run:
+  cycles   - slowest core's execution + idle cycles
+  misses   - cache misses summed over the cores
+  bus      - total bus transactions
+and the host-time speedup of the estimate.
+
+Usage:
+    python3 calibrate_estimate.py                    # print the report
+    python3 calibrate_estimate.py --output FILE.md   # also write it to FILE.md
+"""
+import argparse
+import re
+import statistics
+import subprocess
+import tempfile
+import time
+
+from regression_test import PARAMS, SIM_CMD, stage_cases
+
+# Larger runs, where the queueing model has something to average over.
+WORKLOADS = [
+    ("uniform", "uniform:count=20000,share=0.1"),
+    ("zipf", "zipf:count=20000,share=0.3"),
+    ("lock", "lock:count=20000,share=0.2"),
+    ("prodcons", "prodcons:count=20000,share=0.5"),
+    ("migratory", "migratory:count=20000,share=0.3"),
+    ("stride", "stride:count=20000,footprint=65536,stride=16"),
+]
+
+
+def run(args, cwd=None):
+    start = time.perf_counter()
+    proc = subprocess.run([SIM_CMD] + args, capture_output=True, text=True, cwd=cwd)
+    seconds = time.perf_counter() - start
+    if proc.returncode != 0:
+        raise RuntimeError(f"{' '.join(args)} exited with {proc.returncode}:\n{proc.stderr}")
+    return proc.stdout, seconds
+
+
+def summarise(output):
+    execution = [float(x) for x in re.findall(r"Total Execution Cycles:\s*([\d.]+)", output)]
+    idle = [float(x) for x in re.findall(r"Idle Cycles:\s*([\d.]+)", output)]
+    bus = re.search(r"Total Bus Transactions:\s*(\d+)", output)
+    return {
+        "cycles": max((e + i for e, i in zip(execution, idle)), default=0.0),
+        "misses": sum(int(x) for x in re.findall(r"Cache Misses:\s*(\d+)", output)),
+        "bus": int(bus.group(1)) if bus else 0,
+    }
+
+
+def error(estimate, reference):
+    if reference == 0:
+        return 0.0 if estimate == 0 else float("inf")
+    return 100.0 * (estimate - reference) / reference
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Calibrate --estimate against the cycle model")
+    parser.add_argument("--output", help="also write the report to this file")
+    args = parser.parse_args()
+
+    runs = []
+    with tempfile.TemporaryDirectory() as work_dir:
+        for case in stage_cases(work_dir):
+            runs.append((case, ["-t", case], work_dir))
+    for name, spec in WORKLOADS:
+        runs.append((name, ["-w", spec], None))
+
+    lines = ["| Case | Config | Cycles (model) | Cycles (estimate) | Error | Misses error | Bus error | Speedup |",
+             "|---|---|---:|---:|---:|---:|---:|---:|"]
+    errors = {"trace": [], "workload": []}
+    miss_errors, bus_errors, speedups = [], [], []
+    with tempfile.TemporaryDirectory() as work_dir:
+        stage_cases(work_dir)
+        for case, source, cwd in runs:
+            cwd = work_dir if cwd else None
+            for label, p in PARAMS:
+                geometry = ["-s", str(p["s"]), "-E", str(p["E"]), "-b", str(p["b"])]
+                full, full_seconds = run(source + geometry, cwd)
+                fast, fast_seconds = run(source + geometry + ["--estimate"], cwd)
+                f, e = summarise(full), summarise(fast)
+                cycle_error = error(e["cycles"], f["cycles"])
+                errors["workload" if cwd is None else "trace"].append(abs(cycle_error))
+                miss_errors.append(abs(error(e["misses"], f["misses"])))
+                bus_errors.append(abs(error(e["bus"], f["bus"])))
+                speedup = full_seconds / fast_seconds if fast_seconds > 0 else 0.0
+                if cwd is None:
+                    speedups.append(speedup)
+                lines.append(f"| {case} | {label} | {f['cycles']:.0f} | {e['cycles']:.0f} | {cycle_error:+.1f}% | "
+                             f"{error(e['misses'], f['misses']):+.1f}% | {error(e['bus'], f['bus']):+.1f}% | "
+                             f"{speedup:.1f}x |")
+
+    summary = [
+        "",
+        f"Mean absolute cycle error, test-case traces: {statistics.mean(errors['trace']):.1f}% "
+        f"(max {max(errors['trace']):.1f}%)",
+        f"Mean absolute cycle error, synthetic workloads: {statistics.mean(errors['workload']):.1f}% "
+        f"(max {max(errors['workload']):.1f}%)",
+        f"Mean absolute miss error: {statistics.mean(miss_errors):.1f}%",
+        f"Mean absolute bus transaction error: {statistics.mean(bus_errors):.1f}%",
+        f"Median speedup on synthetic workloads: {statistics.median(speedups):.1f}x",
+    ]
+    report = "\n".join(["# --estimate calibration", ""] + lines + summary) + "\n"
+    print(report, end="")
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(report)
+
+
+if __name__ == "__main__":
+    main()
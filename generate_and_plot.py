@@ -29,25 +29,12 @@ PARAMS = [
 OUTPUT_CSV = "max_cycles.csv"
 
 def parse_max_cycles(output: str) -> int:
-    # The simulator outputs "Global Clock: N cycles" based on main.cpp
-    matches = re.findall(r"Global Clock:\s*(\d+)\s+cycles", output)
+    # The slowest core: the largest per-core "Total Execution Cycles".
+    # (In-process harnesses can read the same counters from libl1sim.)
+    matches = re.findall(r"Total Execution Cycles:\s*(\d+)", output)
     if matches:
-        print(f"Found Global Clock match: {matches[0]}")
-        return int(matches[0])
-    
-    # Try alternative patterns if the first one doesn't match
-    alt_patterns = [
-        r"Global Clock:\s*(\d+)", 
-        r"Total Execution Cycles:\s*(\d+)",
-        r"Cycles:\s*(\d+)"
-    ]
-    
-    for pattern in alt_patterns:
-        matches = re.findall(pattern, output)
-        if matches:
-            print(f"Found match with pattern '{pattern}': {matches[0]}")
-            return int(matches[0])
-    
+        return max(int(m) for m in matches)
+
     # For debugging, print part of the output if no matches
     if output:
         print("Debug - No cycle count found. Output excerpt:")
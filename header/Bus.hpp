@@ -2,7 +2,9 @@
 #define BUS_HPP
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <string>
 
 // Define the bus transaction types.
 enum class BusTransactionType
@@ -20,21 +22,74 @@ struct BusTransaction
     BusTransactionType type; // Type of bus transaction.
     uint32_t address;        // Memory address involved (assumed block-aligned).
     int sourceProcessorId;   // ID of the processor that initiated the transaction.
+    uint64_t issueCycle = 0; // Bus cycle it was queued (set by addTransaction).
 };
 
+// How the bus picks the next demand transaction (BusRd/BusRdX/BusRdWITWr).
+// Upgrades and write-backs keep their fixed precedence under every policy.
+enum class ArbitrationPolicy {
+    Fifo,          // Oldest request first.
+    RoundRobin,    // Next core after the last one granted.
+    FixedPriority, // Lowest core id first.
+    AgeWeighted    // Oldest request, with age scaled up for cores below their fair share of grants.
+};
+
+// Parses "fifo", "rr", "priority" or "age"; returns false if unknown.
+bool parseArbitrationPolicy(const std::string &name, ArbitrationPolicy &policy);
+const char *arbitrationPolicyName(ArbitrationPolicy policy);
+
+// Central snooping bus. Alternative coherence backends (see Directory)
+// derive from it and override the transaction entry points.
 class Bus
 {
 public:
     Bus();
+    virtual ~Bus() {}
 
     // Adds a new bus transaction to the appropriate queue.
-    void addTransaction(const BusTransaction &transaction);
+    virtual void addTransaction(const BusTransaction &transaction);
 
     // Resolves queued transactions.
     // This function is called each simulation cycle.
     // BusUpgr transactions are processed first (from upgradeQueue),
     // then the normal transactions (from transactions vector) are processed.
-    void resolveTransactions(const std::vector<class Cache *> &caches);
+    virtual void resolveTransactions(const std::vector<class Cache *> &caches);
+
+    // Queues a low-priority prefetch read. Returns false if it was dropped
+    // because the prefetch queue is full or already holds that block.
+    virtual bool addPrefetch(const BusTransaction &transaction);
+    // Removes a queued prefetch of this block by this processor (superseded
+    // by a demand miss). Returns true if one was removed.
+    virtual bool cancelPrefetch(uint32_t blockAddress, int sourceProcessorId);
+    // Returns the number of prefetch reads the bus has served.
+    uint64_t getPrefetchTransactions() const { return prefetchTransactions; }
+    // Returns the number of prefetch fills cut short by demand traffic.
+    uint64_t getPreemptedPrefetches() const { return preemptedPrefetches; }
+
+    // Places a shared L2 between the bus and memory (nullptr = none).
+    virtual void setL2(class L2Cache *cache) { l2 = cache; }
+    // Replaces the flat memory latency with a DRAM model (nullptr = none).
+    virtual void setDram(class Dram *memory) { dram = memory; }
+    // Makes this the bus of one cluster (see ClusteredBus): misses no peer
+    // supplies, write-backs and remote invalidations go over `global`.
+    void setInterconnect(class ClusterInterconnect *global) { interconnect = global; }
+    // Absorbs write-backs into a buffer of the given number of blocks that
+    // drains to memory over a dedicated channel (0 = write-backs hold the bus).
+    void setWritebackBufferSize(int entries) { writebackBufferSize = entries; }
+    // Write-back buffer statistics.
+    uint64_t getAbsorbedWritebacks() const { return absorbedWritebacks; }
+    uint64_t getBlockingWritebacks() const { return blockingWritebacks; }
+    uint64_t getWritebackBufferHits() const { return writebackBufferHits; }
+    int getPeakWritebackBuffer() const { return peakWritebackBuffer; }
+
+    // Selects the demand arbitration policy for a system of numCores cores.
+    virtual void setArbitration(ArbitrationPolicy policy, int numCores);
+
+    // Per-core arbitration statistics: cycles between queuing a demand
+    // transaction and the bus starting it.
+    uint64_t getGrants(int core) const { return grants[core]; }
+    uint64_t getTotalWait(int core) const { return totalWait[core]; }
+    uint64_t getMaxWait(int core) const { return maxWait[core]; }
 
     // Clears the transaction queues.
     void clearTransactions();
@@ -42,19 +97,33 @@ public:
     // Process a BusUpgr transaction immediately.
     void processUpgrade(const BusTransaction &tx, const std::vector<class Cache *> &caches);
     // Returns the total number of bus transactions issued.
-    int getTotalBusTransactions() const { return totalBusTransactions; }
+    uint64_t getTotalBusTransactions() const { return totalBusTransactions; }
 
     // Returns the total bus traffic (in bytes).
     // You could update a member variable dataTrafficBytes in Bus.cpp each time a transaction is processed.
-    int getBusTrafficBytes() const { return busTrafficBytes; }
-    int updateBusTrafficBytes(const std::vector<Cache*>& caches);
+    uint64_t getBusTrafficBytes() const { return busTrafficBytes; }
+    uint64_t updateBusTrafficBytes(const std::vector<Cache*>& caches);
     void printBusinfo() const;
     bool getPendingBusWr() const { return pendingBusWr; }
     int getPendingBusWrCycles() const { return pendingBusWrCycles; }
-    bool hasPendingtransaction() const;
+    virtual bool hasPendingtransaction() const;
+    // True if no transaction, prefetch or buffered write-back is left, so
+    // idle cycles can be skipped without resolving them one by one.
+    bool isIdle() const;
+    // Accounts for n idle cycles skipped while isIdle() held.
+    virtual void skipIdleCycles(uint64_t n) { cycle += n; }
+    // Transactions queued but not yet finished (progress snapshots).
+    virtual size_t getQueueDepth() const;
     int getPendingBusWrSource() const { return pendingBusWrSourceId; }
     // Returns the number of bus invalidations seen by this cache.
-    int getBusInvalidations() const { return busInvalidations; }
+    uint64_t getBusInvalidations() const { return busInvalidations; }
+
+protected:
+    // Memory below the L1s, optionally fronted by a shared L2.
+    static const int memoryLatency = 100;
+    uint64_t cycle = 0; // resolveTransactions calls so far (DRAM timing, waits).
+    uint64_t busInvalidations = 0; // Number of bus invalidations.
+    uint64_t totalBusTransactions = 0;
 
 private:
     // FIFO queue for normal transactions.
@@ -62,9 +131,75 @@ private:
     // Separate high-priority queue for upgrade transactions.
     std::vector<BusTransaction> upgradeQueue;
     std::vector<BusTransaction> writebackQueue;
-    int busTrafficBytes = 0;
-    int busInvalidations = 0; // Number of bus invalidations.
-    int totalBusTransactions=0;
+    // Low-priority prefetch reads, served only when the bus is otherwise idle.
+    std::vector<BusTransaction> prefetchQueue;
+    static const size_t maxPrefetchQueue = 16;
+    bool prefetchActive = false;   // A prefetch fill currently holds the bus.
+    int prefetchCycles = 0;        // Cycles left for the active prefetch.
+    BusTransaction activePrefetch;
+    bool activePrefetchShared = false; // Another cache held the block at issue.
+    uint64_t prefetchTransactions = 0;
+    uint64_t preemptedPrefetches = 0;
+    // True if demand traffic is waiting behind the active prefetch (a read
+    // miss on the prefetched block itself is served by that prefetch).
+    bool demandWaiting(const std::vector<class Cache *> &caches) const;
+    // Snoops the head of the prefetch queue and, unless a holder must write
+    // the block back first, puts it on the bus with a demand fill's latency.
+    void startPrefetch(const std::vector<class Cache *> &caches);
+    // Installs the active prefetch once its latency has elapsed.
+    void completePrefetch(const std::vector<class Cache *> &caches);
+    class L2Cache *l2 = nullptr;
+    class Dram *dram = nullptr;
+    class ClusterInterconnect *interconnect = nullptr;
+    // Write-back buffer: block addresses whose dirty data is on its way to
+    // memory. The head drains over the write channel in drainCycles.
+    std::vector<BusTransaction> writebackBuffer;
+    int writebackBufferSize = 0;
+    int drainCycles = 0;
+    uint64_t absorbedWritebacks = 0;
+    uint64_t blockingWritebacks = 0;
+    uint64_t writebackBufferHits = 0;
+    int peakWritebackBuffer = 0;
+    // Moves queued write-backs into the buffer while it has room.
+    void absorbWritebacks(const std::vector<class Cache *> &caches);
+    // Advances the write channel by one cycle.
+    void drainWritebackBuffer(const std::vector<class Cache *> &caches);
+    // True if the buffer still holds the block (it supplies the data).
+    bool writebackBufferHolds(uint32_t address, int blockSizeBytes) const;
+    ArbitrationPolicy arbitration = ArbitrationPolicy::Fifo;
+    int lastGranted = -1;
+    std::vector<uint64_t> grants;
+    std::vector<uint64_t> totalWait;
+    std::vector<uint64_t> maxWait;
+    // True if tx's cache is still waiting for the bus to start it.
+    bool isWaiting(const BusTransaction &tx, const std::vector<class Cache *> &caches) const;
+    // Moves the transaction the arbitration policy picks to the front.
+    // Under FR-FCFS (DRAM without an L2) it picks among open-row hits first.
+    void arbitrate(const std::vector<class Cache *> &caches);
+    // Records the wait of a demand transaction the bus just started.
+    void recordGrant(const BusTransaction &tx);
+    // One block access to memory issued `after` cycles from now: DRAM
+    // timing or the flat latency.
+    int memoryAccess(uint32_t address, bool isWrite, int after = 0);
+    // FR-FCFS: when the bus is free to pick the next memory request, a
+    // queued request hitting an open DRAM row goes before older ones.
+    void scheduleRowHitFirst(const std::vector<class Cache *> &caches);
+    size_t pickWriteback() const;
+    std::vector<uint32_t> backInvalidations; // Scratch buffer.
+    std::vector<uint32_t> l2Writebacks;      // Scratch buffer.
+    // Writes what an L2 allocation evicted to memory, one block after the
+    // other: the dirty victim and any Modified L1 copy an inclusive
+    // back-invalidation removed. Returns the cycles this takes.
+    int writeL2Victims(const std::vector<class Cache *> &caches);
+    // Latency of fetching a block that no L1 supplies.
+    int fetchLatency(uint32_t address, const std::vector<class Cache *> &caches);
+    // Latency of writing a dirty L1 block back below the bus.
+    int writebackLatency(uint32_t address, const std::vector<class Cache *> &caches);
+    // Time a write-back occupies the level below (without performing it).
+    int writebackDuration() const;
+    // Applies the L2's back-invalidations to the L1s.
+    void applyBackInvalidations(const std::vector<class Cache *> &caches);
+    uint64_t busTrafficBytes = 0;
     bool pendingBusWr; // Indicates if a BusWr transaction is pending.
     int pendingBusWrCycles; // Number of cycles remaining for the pending BusWr transaction.
     int pendingBusWrSourceId; // ID of the processor that initiated the pending BusWr transaction.
@@ -2,22 +2,21 @@
 #define CACHE_HPP
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include "DataArray.hpp"
-#include "TagArray.hpp"
+#include "CacheLines.hpp"
 #include "Bus.hpp"  // For bus transactions
-
-// Define MESI protocol states.
-enum class MESIState { Modified, Exclusive, Shared, Invalid };
+#include "Prefetcher.hpp"
 
 enum class HasBlockState { HasBlock, NoBlock, HasBlockBeingWrittenBack };
 
-// Metadata for each cache line.
-struct CacheLineMeta {
+// One line of a victim cache: a recently evicted block and its MESI state.
+struct VictimLine {
     bool valid;
-    bool dirty;
+    uint32_t block;   // Address >> b.
     MESIState state;
-    int lruCounter;  // For LRU replacement policy.
+    int lruCounter;
 };
 
 class Cache {
@@ -28,17 +27,38 @@ public:
     // b: block bits (blockSizeBytes = 2^b)
     // processorId: identifier for the processor owning this cache.
     Cache(int s, int E, int b, int processorId, Bus *busPtr);
+    virtual ~Cache() {}
+
+    // Builds a cache for the given geometry. The common sweep geometries
+    // (s, E, b) = (6,2,5), (7,2,5), (6,2,6) and (6,4,5) get a specialisation
+    // whose masks and way loops are compile-time constants; anything else,
+    // or generic = true, gets this runtime implementation.
+    static Cache *create(int s, int E, int b, int processorId, Bus *busPtr, bool generic = false);
+    // True for the compile-time specialisations.
+    virtual bool isSpecialized() const { return false; }
 
     // Basic read/write functions.
     bool read(uint32_t address, int &cycles);
     bool write(uint32_t address, int &cycles);
 
     // Bus-aware read/write functions.
-    bool read(uint32_t address, int &cycles, Bus *bus);
-    bool write(uint32_t address, int &cycles, Bus *bus);
+    virtual bool read(uint32_t address, int &cycles, Bus *bus);
+    virtual bool write(uint32_t address, int &cycles, Bus *bus);
+    // Atomic read-modify-write: hits only on an Exclusive or Modified
+    // block. Anything else, a Shared copy included, is fetched with a
+    // BusRdWITWr (BusRdX) so the block arrives Modified with its data.
+    bool atomic(uint32_t address, int &cycles, Bus *bus);
 
     // Called by the Bus to resolve a pending transaction.
-    void resolvePendingTransaction(BusTransactionType type, uint32_t address, int delay);
+    // shared: another cache held the block. A read installs it Shared (that
+    // cache supplied it); a write has just invalidated those copies.
+    void resolvePendingTransaction(BusTransactionType type, uint32_t address, int delay, bool shared);
+    // Whether the last resolved miss found the block in another cache
+    // (false for a miss the victim cache served).
+    bool lastFillWasShared() const { return fillShared; }
+    // Whether the last miss was served by a victim cache swap-in, which
+    // restores the block's old state instead of the one the miss asked for.
+    bool lastFillWasSwap() const { return fillSwapped; }
 
     // Called each cycle to check pending delay.
     int getPendingCycleCount() const;
@@ -49,6 +69,23 @@ public:
         uint32_t    getPendingAddress()   const { return pendingAddress; }
     void decrementPendingCycle();
 
+    // Returns true if an access would hit without any bus transaction
+    // (for writes the block must already be Exclusive or Modified).
+    // The first touch of a prefetched block is never local: it trains the
+    // prefetcher, which queues new prefetches on the shared bus.
+    virtual bool hitsLocally(uint32_t address, bool isWrite) const;
+    // Performs a read only if it hits, never starting a transaction; usable
+    // while a miss is outstanding. Returns false on a miss.
+    virtual bool readHit(uint32_t address);
+    // Charges a run of hits to one block at once (LRU and prefetch
+    // bookkeeping happen once, as they would for the first access); any
+    // write in the run leaves the block Modified. The caller guarantees
+    // every access hits. Returns false if the block is not present.
+    bool chargeHits(uint32_t address, bool anyWrite);
+
+    // Returns the MESI state of the block (Invalid if not present).
+    MESIState getBlockState(uint32_t address) const;
+
     // Returns true if the cache holds the block (only if in Shared or Exclusive state).
     bool hasBlock(uint32_t address) const;
 
@@ -61,29 +98,77 @@ public:
 
     // New: Invalidate the block if it is in Shared state.
     void invalidateShared(uint32_t address);
+    // Drops every block inside [address, address + bytes) because an
+    // inclusive L2 evicted it. Returns true if a Modified copy was dropped.
+    bool backInvalidate(uint32_t address, int bytes);
     // Returns the number of cache misses for this cache.
-    int getCacheMisses() const { return cacheMisses; }
+    uint64_t getCacheMisses() const { return cacheMisses; }
 
     // Returns the number of cache evictions.
-    int getEvictions() const { return cacheEvictions; }
+    uint64_t getEvictions() const { return cacheEvictions; }
 
     // Returns the number of writebacks performed.
-    int getWritebacks() const { return writebacks; }
+    uint64_t getWritebacks() const { return writebacks; }
 
     // Returns the number of bus invalidations seen by this cache.
-    int getBusInvalidations() const { return busInvalidations; }
+    uint64_t getBusInvalidations() const { return busInvalidations; }
 
     // Returns the total data traffic (in bytes) generated on the bus by this cache.
-    int getDataTrafficBytes() const { return dataTrafficBytes; }
+    uint64_t getDataTrafficBytes() const { return dataTrafficBytes; }
 
     void printCacheInfo() const;
 
     void installPendingBlock();
 
     void setPendingWritebackCycles(int cycles) { pendingwritebackCycles = cycles; }
+
+    // Attaches a prefetcher to this cache (takes ownership).
+    void setPrefetcher(Prefetcher *p) { prefetcher.reset(p); }
+    bool hasPrefetcher() const { return prefetcher != nullptr; }
+    // Called by the Bus when a prefetch fill completes; `shared` is true
+    // if another cache still holds the block.
+    void installPrefetch(uint32_t address, bool shared);
+
+    // Gives this cache a fully-associative victim cache of the given number
+    // of lines (0 = none). Evicted lines move there with their MESI state and
+    // a miss that finds its block there swaps it back in victimHitLatency
+    // cycles without a bus transaction.
+    void setVictimCacheSize(int entries);
+    // Victim cache statistics.
+    uint64_t getVictimProbes() const { return victimProbes; }
+    uint64_t getVictimHits() const { return victimHits; }
+    // Bus latency avoided by victim hits, estimated against a memory fetch.
+    uint64_t getVictimCyclesSaved() const { return victimCyclesSaved; }
+
+    // Prefetch statistics.
+    uint64_t getPrefetchesIssued() const { return prefetchesIssued; }
+    uint64_t getUsefulPrefetches() const { return usefulPrefetches; }
+    uint64_t getLatePrefetches() const { return latePrefetches; }
+    uint64_t getUnusedPrefetches() const { return unusedPrefetches; }
+    uint64_t getPrefetchTrafficBytes() const { return prefetchTrafficBytes; }
     bool is_writing_to_mem = false; // Indicates if the cache is writing to memory.
     bool modified_invalidated = false; // Indicates if the cache is invalidated after a writeback.
 
+protected:
+    // Geometry as seen by the lookup templates below. The runtime cache
+    // reads it from its members; specialisations pass a type whose shifts,
+    // masks and way count are constants.
+    struct RuntimeGeometry {
+        int s, ways, b;
+        uint32_t tag(uint32_t address) const { return address >> (s + b); }
+        int set(uint32_t address) const { return (address >> b) & ((1 << s) - 1); }
+    };
+    RuntimeGeometry runtimeGeometry() const { return {s, E, b}; }
+
+    // Hit-path implementations shared by the runtime cache and the
+    // specialisations (defined in Cache.cpp).
+    template <class G> int findWayIn(const G &g, int setIndex, uint32_t tag) const;
+    template <class G> void updateLRUIn(const G &g, int setIndex, int way);
+    template <class G> bool readHitIn(const G &g, uint32_t address);
+    template <class G> bool hitsLocallyIn(const G &g, uint32_t address, bool isWrite) const;
+    template <class G> bool readIn(const G &g, uint32_t address, int &cycles, Bus *bus);
+    template <class G> bool writeIn(const G &g, uint32_t address, int &cycles, Bus *bus);
+
 private:
     int s;                // Number of set index bits.
     int E;                // Associativity exponent (number of ways = 2^E).
@@ -93,31 +178,64 @@ private:
     int processorId;      // Processor ID.
 
     DataArray dataArray;  // Data storage array.
-    TagArray tagArray;    // Tag storage array.
-    std::vector<std::vector<CacheLineMeta>> meta;
+    CacheLines lines;     // Tags, line metadata and LRU state.
 
     // Helper functions.
     uint32_t extractTag(uint32_t address) const;
     int extractSetIndex(uint32_t address) const;
     int extractBlockOffset(uint32_t address) const;
     void updateLRU(int setIndex, int way);
+    // Returns the way holding tag in the set, or -1.
+    int findWay(int setIndex, uint32_t tag) const;
+    // Miss paths of read() and write(): start the bus transaction.
+    bool readMiss(uint32_t address, Bus *bus);
+    bool writeMiss(uint32_t address, Bus *bus);
+    // Picks an LRU victim (writing it back if dirty), installs tag in its
+    // place with the given state and makes it most recently used.
+    int installBlock(int setIndex, uint32_t tag, MESIState state);
+    // Victim cache helpers: index of the line holding block (or -1), moving
+    // an evicted line in (writing back whatever it displaces) and swapping
+    // a hit back into the L1 on a miss.
+    int findVictim(uint32_t block) const;
+    void fillVictimCache(uint32_t block, MESIState state);
+    bool swapInFromVictimCache(uint32_t address, BusTransactionType type);
+    // Applies a snooped transaction to a victim cache line.
+    void snoopVictimCache(const BusTransaction &tx);
+    // Offers the prefetcher's candidate blocks to the bus.
+    void issuePrefetches(const std::vector<uint32_t> &blocks);
 
     // Pending transaction information.
     bool pendingTransaction;
     uint32_t pendingAddress;
     BusTransactionType pendingType;
     int pendingCycleCount=0;
-    int cacheMisses = 0; // Cache misses counter.
-    int cacheEvictions = 0;
-    int writebacks = 0;
-    int busInvalidations = 0;
-    int dataTrafficBytes = 0;
+    uint64_t cacheMisses = 0; // Cache misses counter.
+    uint64_t cacheEvictions = 0;
+    uint64_t writebacks = 0;
+    uint64_t busInvalidations = 0;
+    uint64_t dataTrafficBytes = 0;
     int pendingDelay = 0; // Delay for pending transactions.
     bool is_writeback = false; // Indicates if the pending transaction is a writeback.
     bool is_mem_occupied = false; // Indicates if the memory is occupied.
     int pendingwritebackCycles = 0; // Number of cycles for pending writeback.
+    bool fillShared = false; // See lastFillWasShared().
+    bool fillSwapped = false; // See lastFillWasSwap().
     Bus* bus;
-    
+
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::vector<uint32_t> prefetchCandidates; // Scratch buffer.
+    uint64_t prefetchesIssued = 0;
+    uint64_t usefulPrefetches = 0;
+    uint64_t latePrefetches = 0;
+    uint64_t unusedPrefetches = 0;
+    uint64_t prefetchTrafficBytes = 0;
+
+    std::vector<VictimLine> victimCache;
+    static const int victimHitLatency = 1;
+    uint64_t victimProbes = 0;
+    uint64_t victimHits = 0;
+    uint64_t victimCyclesSaved = 0;
+
 };
 
 #endif // CACHE_HPP
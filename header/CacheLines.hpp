@@ -0,0 +1,82 @@
+#ifndef CACHE_LINES_HPP
+#define CACHE_LINES_HPP
+
+#include <cstdint>
+#include <vector>
+#include "TagArray.hpp"
+
+// Define MESI protocol states.
+enum class MESIState { Modified, Exclusive, Shared, Invalid };
+
+// Metadata for each cache line.
+struct CacheLineMeta {
+    bool valid;
+    bool dirty;
+    MESIState state;
+    int lruCounter;  // For LRU replacement policy.
+    bool prefetched; // Brought in by a prefetch and not yet demanded.
+};
+
+// Tags and line metadata of a set-associative cache with LRU replacement.
+// The L1s and the shared L2 both keep their lines here, so lookup, LRU
+// update and victim choice have a single implementation.
+// Every call takes the way count so that callers with a compile-time
+// geometry (FixedGeometryCache) get fully unrolled loops.
+struct CacheLines {
+    TagArray tagArray;
+    std::vector<std::vector<CacheLineMeta>> meta; // meta[set][way]
+
+    // Constructor: every line starts invalid.
+    CacheLines(int ways, int numSets)
+        : tagArray(ways, numSets),
+          meta(numSets, std::vector<CacheLineMeta>(ways, CacheLineMeta{false, false, MESIState::Invalid, 0, false})) {}
+
+    // Returns the way holding a valid copy of tag in the set, or -1.
+    int findWay(int setIndex, uint32_t tag, int ways) const
+    {
+        const std::vector<CacheLineMeta> &lines = meta[setIndex];
+        const std::vector<unsigned int> &tags = tagArray.tags[setIndex];
+        for (int way = 0; way < ways; ++way)
+        {
+            if (lines[way].valid && tags[way] == tag)
+                return way;
+        }
+        return -1;
+    }
+
+    // Makes way the most recently used line of its set.
+    void touch(int setIndex, int way, int ways)
+    {
+        std::vector<CacheLineMeta> &lines = meta[setIndex];
+        lines[way].lruCounter = 0;
+        for (int i = 0; i < ways; ++i)
+        {
+            if (i != way && lines[i].valid)
+                lines[i].lruCounter++;
+        }
+    }
+
+    // Returns the way to fill next: the first invalid one, else the LRU line.
+    int pickVictim(int setIndex, int ways) const
+    {
+        const std::vector<CacheLineMeta> &lines = meta[setIndex];
+        int victim = 0;
+        for (int way = 0; way < ways; ++way)
+        {
+            if (!lines[way].valid)
+                return way;
+            if (lines[way].lruCounter > lines[victim].lruCounter)
+                victim = way;
+        }
+        return victim;
+    }
+
+    // Returns the address of the block held in (setIndex, way) for a cache
+    // with s set-index bits and b block bits.
+    uint32_t blockAddress(int setIndex, int way, int s, int b) const
+    {
+        return (tagArray.tags[setIndex][way] << (s + b)) | (setIndex << b);
+    }
+};
+
+#endif // CACHE_LINES_HPP
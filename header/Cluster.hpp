@@ -0,0 +1,161 @@
+#ifndef CLUSTER_HPP
+#define CLUSTER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Bus.hpp"
+
+// Parameters of the clustered topology (selected with --clusters).
+// All times are in core cycles.
+struct ClusterConfig {
+    int clusters = 2;         // Snooping buses; cores are split evenly, in order.
+    int linkLatency = 20;     // One traversal of the global interconnect.
+    int bytesPerCycle = 16;   // Bandwidth of each cluster's global port, per direction.
+    int headerBytes = 8;      // Size of a request or invalidation; data adds a block.
+};
+
+// Parses "<clusters>[:key=value,...]" into config.
+// Returns false (with a message on std::cerr) if the spec is malformed.
+bool parseClusterSpec(const std::string &spec, ClusterConfig &config);
+
+// Global interconnect between the cluster buses. Memory (and the L2, if
+// any) sits on it, so every fill or write-back memory handles leaves the
+// cluster; so do fills another cluster's cache supplies and invalidations
+// of copies in other clusters. Each cluster has one port per direction
+// that carries bytesPerCycle. Ports are booked by interval, so a data
+// reply booked for when memory answers does not hold up messages that
+// pass through the port before then; a message waits only for overlap.
+// The interconnect knows which clusters hold a block (an exact snoop
+// filter), so requests the cluster can serve never leave it.
+class ClusterInterconnect {
+public:
+    ClusterInterconnect(const ClusterConfig &config, int numCores);
+
+    // Cluster of a core.
+    int clusterOf(int core) const { return core / coresPerCluster; }
+    const ClusterConfig &getConfig() const { return config; }
+    int getCoresPerCluster() const { return coresPerCluster; }
+
+    // Every cache in the system, indexed by core (set once by ClusteredBus).
+    void setCaches(const std::vector<class Cache *> &all);
+    const std::vector<class Cache *> &getCaches() const { return caches; }
+
+    // Shows a demand transaction the source's cluster bus has just
+    // snooped (`local` = that cluster's caches) to the other clusters,
+    // unless it is a BusRd a cluster peer can supply. Returns a mask of
+    // the other clusters that held the block.
+    uint64_t snoopRemote(const BusTransaction &tx, const std::vector<class Cache *> &local);
+    // A cache outside the source's cluster that can supply a BusRd, or nullptr.
+    class Cache *remoteSupplier(const BusTransaction &tx) const;
+    // Invalidates Shared copies in other clusters after an upgrade.
+    void upgradeRemote(const BusTransaction &tx, uint64_t cycle);
+
+    // Total delay of a demand miss that leaves its cluster at `cycle`: the
+    // request crosses to the supplier (core `supplier`'s cluster, or memory
+    // if supplier < 0), which takes `serviceCycles`, and the data crosses
+    // back. The clusters in `holders` must acknowledge an invalidation first.
+    int remoteFill(const BusTransaction &tx, int supplier, int serviceCycles, uint64_t cycle,
+                   uint64_t holders);
+    // Cycles until a write-back leaving `core`'s cluster at `cycle` reaches memory.
+    int writeback(int core, uint64_t cycle);
+    // Records a demand miss served inside its cluster.
+    void recordLocalFill(int delay);
+    // Keeps the block of a fill just granted at the source's cluster until
+    // `until`, the cycle its core retries the access. A cluster bus never
+    // gives a block away before its requester has used it; the hold gives
+    // the interconnect the same guarantee, without which two clusters could
+    // steal a block from each other forever. Meanwhile isHeld() is true for
+    // requests from other clusters.
+    void holdBlock(const BusTransaction &tx, uint64_t until);
+    bool isHeld(const BusTransaction &tx, uint64_t cycle);
+
+    // Statistics.
+    uint64_t getLocalFills() const { return localFills; }
+    uint64_t getLocalFillLatency() const { return localFillLatency; }
+    uint64_t getLocalBytes() const { return localBytes; }
+    uint64_t getRemoteFills() const { return remoteFills; }
+    uint64_t getRemoteFillLatency() const { return remoteFillLatency; }
+    uint64_t getRemoteCacheFills() const { return remoteCacheFills; }
+    uint64_t getRemoteUpgrades() const { return remoteUpgrades; }
+    uint64_t getRemoteWritebacks() const { return remoteWritebacks; }
+    uint64_t getMessages() const { return messages; }
+    uint64_t getRemoteBytes() const { return remoteBytes; }
+    uint64_t getContentionCycles() const { return contentionCycles; }
+
+private:
+    ClusterConfig config;
+    int coresPerCluster;
+    int blockSizeBytes = 0;
+    std::vector<class Cache *> caches;
+    // Booked [start, end) cycles of each cluster's port, per direction,
+    // sorted by start. Bookings that ended before `now` are dropped.
+    struct Booking {
+        uint64_t start;
+        uint64_t end;
+    };
+    std::vector<std::vector<Booking>> upBookings;
+    std::vector<std::vector<Booking>> downBookings;
+    uint64_t now = 0; // Cycle of the current request.
+    struct Hold {
+        int cluster;
+        uint64_t until;
+    };
+    std::unordered_map<uint32_t, Hold> holds; // By block number.
+
+    // Sends `bytes` from cluster `from` to cluster `to` (-1 = memory),
+    // departing at `when`; returns the cycle the last byte arrives.
+    uint64_t send(int from, int to, uint64_t when, int bytes);
+    // Books the first `cycles`-long gap at or after `when`; returns its start.
+    uint64_t reserve(std::vector<Booking> &port, uint64_t when, int cycles);
+
+    uint64_t localFills = 0;
+    uint64_t localFillLatency = 0;
+    uint64_t localBytes = 0;
+    uint64_t remoteFills = 0;
+    uint64_t remoteFillLatency = 0;
+    uint64_t remoteCacheFills = 0; // Remote fills another cluster's cache supplied.
+    uint64_t remoteUpgrades = 0;   // Upgrades that invalidated copies in other clusters.
+    uint64_t remoteWritebacks = 0;
+    uint64_t messages = 0;
+    uint64_t remoteBytes = 0;
+    uint64_t contentionCycles = 0; // Cycles messages waited for busy ports.
+};
+
+// One snooping bus per cluster under a global interconnect. Each cluster
+// bus is a plain Bus with its own queues, arbitration and write-back
+// stalls; its caches and processors are attached to it directly (see
+// getClusterBus). This object only advances the cluster buses in lockstep
+// and sums their counters, like Directory it stands in for the single bus.
+class ClusteredBus : public Bus {
+public:
+    ClusteredBus(const ClusterConfig &config, int numCores);
+
+    // The bus core `core`'s cache and processor use.
+    Bus *getClusterBus(int core) { return clusters[interconnect.clusterOf(core)].get(); }
+    const Bus &getClusterBus(int core) const { return *clusters[interconnect.clusterOf(core)]; }
+    const ClusterInterconnect &getInterconnect() const { return interconnect; }
+
+    // Applied to every cluster bus.
+    void setL2(class L2Cache *cache) override;
+    void setDram(class Dram *memory) override;
+    void setArbitration(ArbitrationPolicy policy, int numCores) override;
+
+    void addTransaction(const BusTransaction &transaction) override;
+    void resolveTransactions(const std::vector<class Cache *> &caches) override;
+    bool hasPendingtransaction() const override;
+    size_t getQueueDepth() const override;
+    void skipIdleCycles(uint64_t n) override;
+    // Prefetching is a single-bus feature.
+    bool addPrefetch(const BusTransaction &) override { return false; }
+    bool cancelPrefetch(uint32_t, int) override { return false; }
+
+private:
+    ClusterInterconnect interconnect;
+    std::vector<std::unique_ptr<Bus>> clusters;
+    std::vector<std::vector<class Cache *>> clusterCaches;
+};
+
+#endif // CLUSTER_HPP
@@ -0,0 +1,45 @@
+#ifndef DECODED_TRACE_HPP
+#define DECODED_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "InstructionSource.hpp"
+
+// A run of consecutive accesses from one core to the same cache block.
+struct BlockRun {
+    uint32_t block;   // Address >> b.
+    uint32_t count;   // Accesses in the run (1..64).
+    uint32_t gap;     // Compute gap before the first access; later ones have none.
+    OperationType special; // ATOMIC or FENCE: a run of just that record; READ otherwise.
+    uint64_t opMask;  // Bit i set if the i-th access is a write.
+};
+
+// Trace pre-decoded for one block size: addresses become block IDs and
+// consecutive same-block accesses collapse into BlockRun records.
+// Instructions are handed out with the block's base address, which every
+// part of the simulator treats exactly like the original word address
+// (only the store buffer's word forwarding needs the word).
+class DecodedTraceSource : public InstructionSource {
+public:
+    DecodedTraceSource(const std::string &traceFile, int b);
+
+    bool next(Instruction &inst) override;
+    uint64_t size() const override { return total; }
+
+    uint32_t runRemaining() const override;
+    uint64_t runWriteMask() const override;
+    void skipRun(uint32_t n) override;
+
+    // Number of run records (for reporting the compaction).
+    size_t runCount() const { return runs.size(); }
+
+private:
+    std::vector<BlockRun> runs;
+    int b;
+    uint64_t total;
+    size_t runIndex;   // Run holding the next instruction.
+    uint32_t position; // Index of the next instruction within that run.
+};
+
+#endif // DECODED_TRACE_HPP
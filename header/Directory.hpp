@@ -0,0 +1,99 @@
+#ifndef DIRECTORY_HPP
+#define DIRECTORY_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Bus.hpp"
+#include "Mesh.hpp"
+
+// Parameters of the directory coherence backend (selected with --directory).
+// All times are in core cycles.
+struct DirectoryConfig {
+    int pointers = 0;      // Sharer pointers per entry; 0 = full bit map.
+    int hopLatency = 2;    // Router plus link traversal per mesh hop.
+    int flitBytes = 16;    // Link width; data messages add one header flit.
+    int lookupLatency = 10; // Directory access at the home node.
+};
+
+// Parses "full|limited[:key=value,...]" into config.
+// Returns false (with a message on std::cerr) if the spec is malformed.
+bool parseDirectorySpec(const std::string &spec, DirectoryConfig &config);
+
+// Memory-side directory that replaces the snooping bus.
+// Blocks are interleaved across one home node per core on a 2-D mesh.
+// Each miss sends a request to its home, which answers from memory or
+// forwards it to the owning cache, and invalidates only the caches its
+// entry lists as sharers. The Cache MESI transitions are the ones the bus
+// drives; only who sees each transaction and how long it takes change.
+// Unlike the bus, requests to different blocks proceed concurrently;
+// requests to the same block are serialised at the home node.
+class Directory : public Bus {
+public:
+    Directory(const DirectoryConfig &config, int numCores, int blockSizeBytes);
+
+    void addTransaction(const BusTransaction &transaction) override;
+    void resolveTransactions(const std::vector<class Cache *> &caches) override;
+    bool hasPendingtransaction() const override;
+    size_t getQueueDepth() const override;
+    // Prefetching is a bus-only feature.
+    bool addPrefetch(const BusTransaction &) override { return false; }
+    bool cancelPrefetch(uint32_t, int) override { return false; }
+
+    const DirectoryConfig &getConfig() const { return config; }
+    const Mesh &getMesh() const { return mesh; }
+
+    // Statistics.
+    uint64_t getRequests() const { return requests; }
+    uint64_t getTotalRequestLatency() const { return totalRequestLatency; }
+    uint64_t getUpgrades() const { return upgrades; }
+    uint64_t getForwards() const { return forwards; }
+    uint64_t getStaleForwards() const { return staleForwards; }
+    uint64_t getInvalidations() const { return invalidations; }
+    uint64_t getBroadcasts() const { return broadcasts; }
+    uint64_t getWritebacks() const { return writebackMessages; }
+
+private:
+    struct Entry {
+        uint64_t sharers = 0;   // Bit i: core i may hold the block.
+        int owner = -1;         // Core holding it Exclusive/Modified.
+        bool overflow = false;  // Limited pointers ran out: sharers unknown.
+        uint64_t busyUntil = 0; // Home is serving an earlier request until then.
+    };
+
+    DirectoryConfig config;
+    int numCores;
+    int blockSizeBytes;
+    int dataFlits;
+    Mesh mesh;
+    std::unordered_map<uint32_t, Entry> entries; // By block number.
+
+    std::vector<BusTransaction> pending;    // Demand misses not yet started.
+    std::vector<BusTransaction> starting;   // Scratch: misses started this cycle.
+    std::vector<BusTransaction> upgradeQueue;
+    std::vector<BusTransaction> writebackQueue;
+    bool forwarding = false; // Write-backs now are part of a forwarded request.
+
+    int homeOf(uint32_t block) const { return static_cast<int>(block % numCores); }
+    // Adds a sharer, switching to broadcast once the pointers run out.
+    void addSharer(Entry &entry, int core);
+    // Sends invalidations to every (possible) sharer except `requester`,
+    // starting at `when`; returns when the last ack reaches the requester.
+    uint64_t invalidateSharers(Entry &entry, const BusTransaction &tx, uint64_t when,
+                               const std::vector<class Cache *> &caches);
+    void serveRequest(const BusTransaction &tx, class Cache *src, const std::vector<class Cache *> &caches);
+    void serveUpgrade(const BusTransaction &tx, const std::vector<class Cache *> &caches);
+    void serveWriteback(const BusTransaction &tx, const std::vector<class Cache *> &caches);
+
+    uint64_t requests = 0;
+    uint64_t totalRequestLatency = 0;
+    uint64_t upgrades = 0;
+    uint64_t forwards = 0;      // Served cache to cache (3-hop).
+    uint64_t staleForwards = 0; // Owner had silently dropped the block.
+    uint64_t invalidations = 0;
+    uint64_t broadcasts = 0;    // Invalidations sent to every core.
+    uint64_t writebackMessages = 0;
+};
+
+#endif // DIRECTORY_HPP
@@ -0,0 +1,74 @@
+#ifndef DRAM_HPP
+#define DRAM_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Timing parameters of the DRAM backend (selected with --dram).
+// All times are in core cycles.
+struct DramConfig {
+    bool openPage = true; // Keep rows open after an access (else auto-precharge).
+    int banks = 8;
+    int rowBytes = 2048;  // Bytes per row (per bank).
+    int tRCD = 40;        // Activate to column command.
+    int tCL = 40;         // Column command to first data.
+    int tRP = 40;         // Precharge.
+    int burst = 8;        // Data transfer of one block.
+};
+
+// Parses "open|closed[:key=value,...]" into config.
+// Returns false (with a message on std::cerr) if the spec is malformed.
+bool parseDramSpec(const std::string &spec, DramConfig &config);
+
+// Banked DRAM with one row buffer per bank.
+// Addresses map as | row | bank | column |, so consecutive rows of the
+// address space interleave across banks.
+class Dram {
+public:
+    explicit Dram(const DramConfig &config);
+
+    // Performs one block access issued at cycle `now` and returns its
+    // latency, including any wait for the bank to finish earlier work.
+    int access(uint32_t address, bool isWrite, uint64_t now);
+
+    // True if the address's row is open in its bank (FR-FCFS "first ready").
+    bool isRowHit(uint32_t address) const;
+
+    // Latency of an access to a closed bank, used where the bus needs a
+    // nominal memory time without issuing a request.
+    int rowMissLatency() const { return config.tRCD + config.tCL + config.burst; }
+
+    const DramConfig &getConfig() const { return config; }
+
+    // Statistics.
+    uint64_t getRequests() const { return reads + writes; }
+    uint64_t getReads() const { return reads; }
+    uint64_t getWrites() const { return writes; }
+    uint64_t getRowHits() const { return rowHits; }
+    uint64_t getRowMisses() const { return rowMisses; }
+    uint64_t getRowConflicts() const { return rowConflicts; }
+    uint64_t getTotalLatency() const { return totalLatency; }
+
+private:
+    struct Bank {
+        bool open;
+        uint32_t row;
+        uint64_t readyAt; // First cycle the bank can take a new command.
+    };
+
+    DramConfig config;
+    std::vector<Bank> banks;
+
+    int bankOf(uint32_t address) const { return (address / config.rowBytes) % config.banks; }
+    uint32_t rowOf(uint32_t address) const { return address / config.rowBytes / config.banks; }
+
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t rowHits = 0;
+    uint64_t rowMisses = 0;    // Bank was precharged.
+    uint64_t rowConflicts = 0; // Another row was open.
+    uint64_t totalLatency = 0;
+};
+
+#endif // DRAM_HPP
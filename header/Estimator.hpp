@@ -0,0 +1,84 @@
+#ifndef ESTIMATOR_HPP
+#define ESTIMATOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "InstructionSource.hpp"
+
+struct SimulationConfig;
+
+// Per-core results of the fast estimate (--estimate).
+struct EstimateCoreStats {
+    uint64_t instructions = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t hits = 0;
+    // Misses by who serves them.
+    uint64_t memoryFills = 0;
+    uint64_t cacheToCacheFills = 0;
+    // Bus work that is not a miss.
+    uint64_t upgrades = 0;    // Writes to Shared blocks.
+    uint64_t writebacks = 0;  // Dirty blocks evicted or snooped away.
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0; // Write misses and upgrades, as Cache counts them.
+    uint64_t dataTrafficBytes = 0;
+
+    // Inputs to the queueing model.
+    uint64_t busRequests = 0;   // Transactions that hold the bus.
+    double busDemand = 0.0;     // Sum of their bus holding times.
+    double localCycles = 0.0;   // Everything else: compute gaps, hits, miss overheads, snoop write-back stalls.
+
+    // Outputs of the queueing model.
+    double busWait = 0.0;       // Expected cycles waiting for other cores' transactions.
+    double executionCycles() const { return localCycles + busDemand; }
+    double totalCycles() const { return executionCycles() + busWait; }
+    uint64_t misses() const { return memoryFills + cacheToCacheFills; }
+};
+
+// First-cut sizing without the cycle loop. Each core's accesses update
+// functional MESI caches (same state rules and latencies as Cache and Bus,
+// cores interleaved by their uncontended local time), and bus contention is
+// then estimated with approximate mean value analysis: the bus is one
+// FCFS server, each core a closed customer that alternates between local
+// work and bus transactions.
+class Estimator {
+public:
+    explicit Estimator(const SimulationConfig &config);
+
+    // Consumes the configured traces or workload.
+    void run();
+
+    const std::vector<EstimateCoreStats> &getCores() const { return cores; }
+    uint64_t getBusTransactions() const;
+    uint64_t getBusTrafficBytes() const;
+    // Fraction of the estimated run time the bus is busy.
+    double getBusUtilization() const;
+    // Estimated cycles until the slowest core finishes.
+    double getEstimatedCycles() const;
+    int getModelIterations() const { return modelIterations; }
+
+private:
+    struct Line {
+        uint32_t tag;
+        uint8_t state; // MESIState.
+        uint64_t lastUse;
+    };
+
+    int s, E, b, numCores;
+    std::vector<std::unique_ptr<InstructionSource>> sources;
+    std::vector<std::vector<Line>> caches; // Per core: sets x ways.
+    std::vector<EstimateCoreStats> cores;
+    uint64_t useClock = 0;
+    int modelIterations = 0;
+
+    Line *find(int core, uint32_t address);
+    // Installs a block in `core`, evicting (and writing back) the LRU line.
+    void install(int core, uint32_t address, uint8_t state);
+    void access(int core, const Instruction &inst);
+    // A transaction that holds the bus for `cycles`.
+    void busRequest(int core, double cycles);
+    void solveQueueingModel();
+};
+
+#endif // ESTIMATOR_HPP
@@ -0,0 +1,148 @@
+#ifndef EVENT_TRACE_HPP
+#define EVENT_TRACE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bit mask of the trace categories compiled into this build (bit i enables
+// TraceCategory i). Trace points of disabled categories are removed by the
+// compiler, so the default build pays nothing for them; `make debug`
+// enables every category (or TRACE_CATEGORIES=<mask> for a subset).
+#ifndef EVENT_TRACE_CATEGORIES
+#define EVENT_TRACE_CATEGORIES 0
+#endif
+
+enum class TraceCategory : uint8_t { Cache, Snoop, Bus, Processor, Count };
+
+enum class TraceEvent : uint8_t
+{
+    CacheHit,        // arg: 1 for a write.
+    CacheMiss,       // arg: 1 for a write.
+    CacheFill,       // arg: new MESI state | delay << 8.
+    CacheEvict,      // arg: MESI state of the evicted line.
+    SnoopDowngrade,  // arg: MESI state before the downgrade to Shared.
+    SnoopInvalidate, // arg: MESI state before the invalidation.
+    BusQueue,        // arg: BusTransactionType.
+    BusGrant,        // arg: delay charged to the requester.
+    ProcRetire,      // arg: OperationType.
+    Count
+};
+
+// One binary record; files are a TraceFileHeader followed by these.
+struct TraceRecord
+{
+    uint64_t cycle;
+    uint32_t address;
+    uint32_t arg;
+    int16_t core;
+    uint8_t category;
+    uint8_t event;
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout is part of the file format");
+
+struct TraceFileHeader
+{
+    char magic[8];        // "L1EVENT\0"
+    uint32_t version;
+    uint32_t recordBytes; // sizeof(TraceRecord)
+};
+
+// Runtime filters applied before a record enters the ring buffer.
+struct TraceFilter
+{
+    uint64_t coreMask = ~0ULL;           // Bit i keeps core i.
+    uint32_t addressLow = 0;             // Inclusive address range.
+    uint32_t addressHigh = UINT32_MAX;
+    uint64_t cycleFrom = 0;              // Inclusive global cycle window.
+    uint64_t cycleTo = UINT64_MAX;
+};
+
+// Parses "0,2,5" into a core mask. Returns false (after printing to
+// std::cerr) on a malformed list.
+bool parseTraceCores(const std::string &list, uint64_t &mask);
+// Parses "lo-hi" (decimal or 0x-prefixed hex) into an inclusive range.
+bool parseTraceRange(const std::string &range, uint64_t &low, uint64_t &high);
+
+const char *traceCategoryName(TraceCategory category);
+const char *traceEventName(TraceEvent event);
+
+// Records simulator events into an in-memory ring buffer that a background
+// thread drains to a binary file. Producers block (rather than drop
+// records) when the buffer is full.
+class EventTracer
+{
+public:
+    EventTracer(const std::string &path, const TraceFilter &filter, size_t capacityRecords = 1 << 16);
+    // Drains the buffer, stops the writer thread and closes the file.
+    ~EventTracer();
+
+    bool isOpen() const { return file != nullptr; }
+
+    void record(TraceCategory category, TraceEvent event, int core, uint32_t address, uint32_t arg);
+
+    // Records that passed the filters, and the times a producer had to wait
+    // for the writer.
+    uint64_t getRecorded() const { return head.load(std::memory_order_relaxed); }
+    uint64_t getProducerStalls() const { return producerStalls; }
+
+    // The tracer trace points report to (nullptr = tracing off) and the
+    // global cycle stamped on each record.
+    static EventTracer *active;
+    static std::atomic<uint64_t> cycle;
+    // Overrides `cycle` for records made by the calling thread. Run-ahead
+    // threads set it to their core's own cycle, which is ahead of the
+    // global one (UINT64_MAX = use `cycle`).
+    static thread_local uint64_t threadCycle;
+
+private:
+    void writerLoop();
+
+    FILE *file;
+    TraceFilter filter;
+    std::vector<TraceRecord> ring;
+    size_t mask;
+    std::atomic<uint64_t> head; // Next slot producers fill.
+    std::atomic<uint64_t> tail; // Next slot the writer drains.
+    std::atomic<bool> stopping;
+    std::mutex producerLock;    // Serialises cores in parallel mode.
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    uint64_t producerStalls = 0;
+    std::thread writer;
+};
+
+// Trace points. The category check is a compile-time constant, so disabled
+// categories generate no code.
+#define TRACE_ENABLED(category) \
+    ((EVENT_TRACE_CATEGORIES & (1u << static_cast<unsigned>(TraceCategory::category))) != 0)
+
+#define TRACE_EVENT(category, event, core, address, arg)                                        \
+    do                                                                                         \
+    {                                                                                          \
+        if (TRACE_ENABLED(category) && EventTracer::active)                                    \
+            EventTracer::active->record(TraceCategory::category, TraceEvent::event, (core),     \
+                                        (address), static_cast<uint32_t>(arg));                \
+    } while (0)
+
+#define TRACE_SET_CYCLE(value)                                                   \
+    do                                                                           \
+    {                                                                            \
+        if (EVENT_TRACE_CATEGORIES != 0)                                         \
+            EventTracer::cycle.store((value), std::memory_order_relaxed);        \
+    } while (0)
+
+#define TRACE_SET_THREAD_CYCLE(value)                                            \
+    do                                                                           \
+    {                                                                            \
+        if (EVENT_TRACE_CATEGORIES != 0)                                         \
+            EventTracer::threadCycle = (value);                                  \
+    } while (0)
+
+#endif // EVENT_TRACE_HPP
@@ -0,0 +1,117 @@
+#ifndef INSTRUCTION_SOURCE_HPP
+#define INSTRUCTION_SOURCE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "TraceParser.hpp"
+
+// A stream of instructions feeding one Processor.
+// Sources are pulled one instruction at a time so that generated workloads
+// never have to be materialised in memory.
+class InstructionSource {
+public:
+    virtual ~InstructionSource() {}
+
+    // Fetches the next instruction; returns false once the stream is exhausted.
+    virtual bool next(Instruction &inst) = 0;
+
+    // Total number of instructions this source produces.
+    virtual uint64_t size() const = 0;
+
+    // Same-block run support (pre-decoded sources only).
+    // Number of upcoming instructions that touch the same block as the one
+    // last returned by next(); 0 if unknown.
+    virtual uint32_t runRemaining() const { return 0; }
+    // Bit i is set if the i-th of those upcoming instructions is a write.
+    virtual uint64_t runWriteMask() const { return 0; }
+    // Consumes n of those instructions (n <= runRemaining()) without
+    // returning them.
+    virtual void skipRun(uint32_t n) { (void)n; }
+};
+
+// Source backed by an in-memory trace (e.g. a parsed trace file).
+class TraceSource : public InstructionSource {
+public:
+    explicit TraceSource(std::vector<Instruction> instructions)
+        : instructions(std::move(instructions)), position(0) {}
+
+    // Parses the given trace file.
+    explicit TraceSource(const std::string &traceFile)
+        : instructions(TraceParser::parseTraceFile(traceFile)), position(0) {}
+
+    bool next(Instruction &inst) override
+    {
+        if (position >= instructions.size())
+            return false;
+        inst = instructions[position++];
+        return true;
+    }
+
+    uint64_t size() const override { return instructions.size(); }
+
+private:
+    std::vector<Instruction> instructions;
+    size_t position;
+};
+
+// Source over instructions [begin, end) of a trace shared with other
+// sources (SimPoint slices).
+class SliceSource : public InstructionSource {
+public:
+    SliceSource(std::shared_ptr<const std::vector<Instruction>> trace, size_t begin, size_t end)
+        : trace(std::move(trace)), position(begin)
+    {
+        this->end = std::min(end, this->trace->size());
+        this->begin = std::min(begin, this->end);
+        position = this->begin;
+    }
+
+    bool next(Instruction &inst) override
+    {
+        if (position >= end)
+            return false;
+        inst = (*trace)[position++];
+        return true;
+    }
+
+    uint64_t size() const override { return end - begin; }
+
+private:
+    std::shared_ptr<const std::vector<Instruction>> trace;
+    size_t begin, end;
+    size_t position;
+};
+
+// Source that is appended to while the simulation runs (libl1sim).
+// Running dry does not end the stream: Simulator::resume() lets the core
+// fetch again once more instructions arrive.
+class BatchSource : public InstructionSource {
+public:
+    void append(const Instruction &inst)
+    {
+        pending.push_back(inst);
+        appended++;
+    }
+
+    bool next(Instruction &inst) override
+    {
+        if (pending.empty())
+            return false;
+        inst = pending.front();
+        pending.pop_front();
+        return true;
+    }
+
+    uint64_t size() const override { return appended; }
+
+private:
+    std::deque<Instruction> pending;
+    uint64_t appended = 0;
+};
+
+#endif // INSTRUCTION_SOURCE_HPP
@@ -0,0 +1,63 @@
+#ifndef L2_CACHE_HPP
+#define L2_CACHE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "CacheLines.hpp"
+
+// Shared last-level cache between the bus and memory.
+// Keeps its lines in the same CacheLines array (tags, metadata, LRU) as the
+// L1s but holds no coherence state: a line is only valid/dirty. Lines are filled on every
+// L1 fetch that memory would have served and on every L1 write-back.
+class L2Cache {
+public:
+    // s: set index bits, E: number of ways, b: block bits,
+    // hitLatency: cycles for an L2 lookup.
+    // An inclusive L2 back-invalidates the L1 copies of every block it evicts.
+    L2Cache(int s, int E, int b, int hitLatency, bool inclusive);
+
+    // Looks up (and on a miss allocates) the block holding address.
+    // Evicted blocks that the L1s must drop are appended to backInvalidations
+    // (inclusive only), and a dirty victim that memory must take is appended
+    // to writebacks. Returns true on a hit; a read miss must additionally
+    // wait for memory, while a write-back carries the whole block and never does.
+    bool access(uint32_t address, bool isWrite, std::vector<uint32_t> &backInvalidations,
+                std::vector<uint32_t> &writebacks);
+
+    // Called when a back-invalidation removed a Modified L1 copy: its data
+    // goes straight to memory.
+    void countDirtyBackInvalidation() { dirtyBackInvalidations++; }
+
+    int getBlockSizeBytes() const { return blockSizeBytes; }
+    int getHitLatency() const { return hitLatency; }
+    bool isInclusive() const { return inclusive; }
+
+    // Statistics.
+    uint64_t getAccesses() const { return hits + misses; }
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+    uint64_t getEvictions() const { return evictions; }
+    uint64_t getWritebacks() const { return writebackCount; }
+    uint64_t getBackInvalidations() const { return backInvalidationCount; }
+    uint64_t getDirtyBackInvalidations() const { return dirtyBackInvalidations; }
+
+private:
+    int s;
+    int E;
+    int b;
+    int numSets;
+    int blockSizeBytes;
+    int hitLatency;
+    bool inclusive;
+
+    CacheLines lines;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t writebackCount = 0;
+    uint64_t backInvalidationCount = 0;
+    uint64_t dirtyBackInvalidations = 0;
+};
+
+#endif // L2_CACHE_HPP
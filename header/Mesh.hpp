@@ -0,0 +1,66 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <cstdint>
+#include <vector>
+
+// 2-D mesh on-chip network with one node per core.
+// Messages use dimension-ordered (XY) routing. Every directed link carries
+// one flit per cycle. Links are booked by time, not by call order, so a
+// message sent later for an earlier cycle can use a gap before traffic that
+// was booked ahead of it.
+class Mesh {
+public:
+    // Lays numNodes out row by row on the smallest near-square grid.
+    Mesh(int numNodes, int hopLatency);
+
+    // Sends a message of `flits` flits from node `from` to node `to`,
+    // departing at cycle `when`. Reserves the links along the route and
+    // returns the cycle the last flit arrives.
+    uint64_t send(int from, int to, uint64_t when, int flits);
+
+    // Sets the current cycle; no later send departs before it, so bookings
+    // that ended earlier are dropped.
+    void setNow(uint64_t cycle) { now = cycle; }
+
+    // Number of links between two nodes.
+    int hops(int from, int to) const;
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getHopLatency() const { return hopLatency; }
+
+    // Statistics.
+    uint64_t getMessages() const { return messages; }
+    uint64_t getFlits() const { return flits; }
+    uint64_t getFlitHops() const { return flitHops; }
+    uint64_t getTotalLatency() const { return totalLatency; }
+    uint64_t getContentionCycles() const { return contentionCycles; }
+
+private:
+    int rows;
+    int cols;
+    int hopLatency;
+    // Booked [start, end) cycles of each directed link, sorted by start and
+    // indexed by node * 4 + port.
+    struct Booking {
+        uint64_t start;
+        uint64_t end;
+    };
+    std::vector<std::vector<Booking>> linkBookings;
+    uint64_t now = 0;
+
+    // Books the first `cycles`-long gap on a link at or after `when`;
+    // returns its start.
+    uint64_t reserve(std::vector<Booking> &link, uint64_t when, int cycles);
+
+    enum Port { East, West, North, South };
+
+    uint64_t messages = 0;
+    uint64_t flits = 0;
+    uint64_t flitHops = 0;
+    uint64_t totalLatency = 0;     // Sum of send-to-arrival times.
+    uint64_t contentionCycles = 0; // Cycles messages waited for busy links.
+};
+
+#endif // MESH_HPP
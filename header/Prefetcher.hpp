@@ -0,0 +1,89 @@
+#ifndef PREFETCHER_HPP
+#define PREFETCHER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware prefetchers that can sit beside an L1 Cache.
+enum class PrefetcherKind { None, NextLine, Stride, Stream };
+
+// Parses "none", "nextline", "stride" or "stream"; returns false otherwise.
+bool parsePrefetcherKind(const std::string &name, PrefetcherKind &kind);
+const char *prefetcherKindName(PrefetcherKind kind);
+
+// A prefetcher observes the demand stream of one cache (in block numbers,
+// i.e. address >> b) and proposes blocks to fetch ahead of use.
+class Prefetcher {
+public:
+    virtual ~Prefetcher() {}
+
+    // Called on every demand miss.
+    virtual void onMiss(uint32_t block, std::vector<uint32_t> &candidates) = 0;
+
+    // Called when a demand access hits a block that was brought in by a prefetch.
+    virtual void onPrefetchHit(uint32_t block, std::vector<uint32_t> &candidates)
+    {
+        (void)block;
+        (void)candidates;
+    }
+
+    // Creates a prefetcher issuing up to `degree` blocks per trigger
+    // (nullptr for PrefetcherKind::None).
+    static Prefetcher *create(PrefetcherKind kind, int degree);
+};
+
+// Fetches the next `degree` sequential blocks after every miss.
+class NextLinePrefetcher : public Prefetcher {
+public:
+    explicit NextLinePrefetcher(int degree) : degree(degree) {}
+    void onMiss(uint32_t block, std::vector<uint32_t> &candidates) override;
+    void onPrefetchHit(uint32_t block, std::vector<uint32_t> &candidates) override;
+
+private:
+    int degree;
+};
+
+// Detects a constant stride in the miss stream (there are no PCs in the
+// traces) and, once it has been seen twice in a row, runs ahead along it.
+class StridePrefetcher : public Prefetcher {
+public:
+    explicit StridePrefetcher(int degree) : degree(degree) {}
+    void onMiss(uint32_t block, std::vector<uint32_t> &candidates) override;
+
+private:
+    int degree;
+    bool hasLast = false;
+    uint32_t lastBlock = 0;
+    int64_t lastStride = 0;
+    bool confirmed = false;
+};
+
+// A small set of stream trackers in the style of Jouppi's stream buffers:
+// a miss that continues a tracked ascending or descending stream advances
+// it `degree` blocks ahead; any other miss reallocates the least recently
+// used tracker.
+class StreamPrefetcher : public Prefetcher {
+public:
+    StreamPrefetcher(int degree, int numStreams = 4);
+    void onMiss(uint32_t block, std::vector<uint32_t> &candidates) override;
+    void onPrefetchHit(uint32_t block, std::vector<uint32_t> &candidates) override;
+
+private:
+    struct Stream {
+        bool valid = false;
+        bool trained = false;   // Direction confirmed by a second miss.
+        uint32_t lastBlock = 0; // Last block demanded from this stream.
+        int direction = 1;      // +1 ascending, -1 descending.
+        uint32_t head = 0;      // Next block to prefetch.
+        uint64_t lastUse = 0;
+    };
+    int degree;
+    std::vector<Stream> streams;
+    uint64_t useClock = 0;
+
+    // Tops the stream up so that it runs `degree` blocks ahead of `block`.
+    void runAhead(Stream &stream, uint32_t block, std::vector<uint32_t> &candidates);
+};
+
+#endif // PREFETCHER_HPP
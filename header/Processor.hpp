@@ -1,50 +1,174 @@
 #ifndef PROCESSOR_HPP
 #define PROCESSOR_HPP
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "Cache.hpp"
 #include "TraceParser.hpp"
+#include "InstructionSource.hpp"
 #include "Bus.hpp"  // Added for bus transactions support
+#include "Tlb.hpp"
+#include <deque>
+
+// One core's activity on one lock: a block it has issued an atomic to.
+struct LockCounters {
+    uint64_t atomics = 0;          // Atomic read-modify-writes performed.
+    uint64_t contendedAtomics = 0; // Of those, misses that took the block from another cache.
+    uint64_t atomicCycles = 0;     // Issue-to-completion cycles, summed.
+    uint64_t spinReads = 0;        // Plain reads of the block once it is a lock.
+    uint64_t spinMisses = 0;       // Misses among those reads (the block was taken away).
+};
 
 class Processor {
 public:
     Processor(int id, const std::string &traceFile, Cache* cache, Bus* bus);
+    // Runs instructions pulled from the given source (takes ownership).
+    Processor(int id, InstructionSource* source, Cache* cache, Bus* bus);
+    // Continues with instructions from a new source (takes ownership);
+    // statistics keep accumulating.
+    void setSource(InstructionSource* newSource);
+    // Fetches again from the current source if it had run dry.
+    void resume();
     
     // Simulate one cycle for this processor.
     void executeCycle();
     // New overload: simulate one cycle for this processor with a Bus pointer.
     void executeCycle(Bus *bus);
+    // Parallel mode: the number of cycles, at most maxCycles, this core can
+    // run from now on without the bus while nothing snoops its L1 (compute
+    // gaps, and hits translated by TLB hits). Fetches the instructions it
+    // looks at ahead of time.
+    uint64_t localHorizon(uint64_t maxCycles);
+    // Runs n <= localHorizon() cycles.
+    void runLocal(uint64_t n);
     // Returns the total number of instructions in this core's trace.
-    int getTotalInstructions() const { return instructions.size(); }
+    uint64_t getTotalInstructions() const { return source->size(); }
 
     // Returns the total number of read instructions executed.
-    int getTotalReads() const { return totalReadInstructions; }
+    uint64_t getTotalReads() const { return totalReadInstructions; }
 
     // Returns the total number of write instructions executed.
-    int getTotalWrites() const { return totalWriteInstructions; }
+    uint64_t getTotalWrites() const { return totalWriteInstructions; }
     // Check if the processor has finished processing its trace.
     bool isFinished() const;
     // Get total and idle cycle counts for statistics.
-    int getTotalCycles() const;
-    int getIdleCycles() const;
-    int getInstructionsExecuted() const { return currentInstructionIndex; }
+    uint64_t getTotalCycles() const;
+    uint64_t getIdleCycles() const;
+    uint64_t getInstructionsExecuted() const { return currentInstructionIndex; }
+
+    // Cycles spent on the trace's compute gaps (part of execution cycles).
+    uint64_t getComputeCycles() const { return computeCycles; }
+    // Cycles this core will spend computing, touching neither its cache
+    // nor the bus, before its next access; 0 if it has other work pending.
+    uint64_t getComputeCyclesAhead() const;
+    // Fast-forwards n <= getComputeCyclesAhead() compute cycles at once.
+    void skipCompute(uint64_t n);
+    // Cycles of work ahead that need no bus: the compute gap or, with a
+    // pre-decoded source, the current same-block run if every access in it
+    // is a guaranteed hit. 0 if the core has anything else to do.
+    uint64_t getLocalCyclesAhead() const;
+    // Fast-forwards n <= getLocalCyclesAhead() cycles at once.
+    void skipLocal(uint64_t n);
+
+    // Enables a TSO store buffer of the given number of entries (0 = none).
+    // Stores retire into the buffer and drain to L1 in program order while
+    // the cache port is otherwise idle; loads forward from matching words.
+    void setStoreBufferSize(int entries) { storeBufferCapacity = entries; }
+    bool hasStoreBuffer() const { return storeBufferCapacity > 0; }
+    // Store buffer statistics.
+    uint64_t getStoresBuffered() const { return storesBuffered; }
+    uint64_t getLoadsForwarded() const { return loadsForwarded; }
+    // Cycles the core retired instructions while a store miss was draining.
+    uint64_t getStoreStallCyclesSaved() const { return storeStallCyclesSaved; }
+    uint64_t getStoreBufferFullStalls() const { return storeBufferFullStalls; }
+
+    // Atomic and fence records retired.
+    uint64_t getAtomics() const { return totalAtomics; }
+    uint64_t getFences() const { return totalFences; }
+    // Cycles fences and atomics waited for the store buffer to drain.
+    uint64_t getFenceStallCycles() const { return fenceStallCycles; }
+    // Per-lock activity, keyed by block address. A block counts as a lock
+    // for this core from its first atomic on; earlier reads are not spins.
+    const std::unordered_map<uint32_t, LockCounters> &getLocks() const { return locks; }
+
+    // Translates trace addresses through the given TLB (not owned); misses
+    // walk the page table with reads through this core's L1.
+    void setTlb(Tlb *translationBuffer) { tlb = translationBuffer; }
+    // L1 reads issued by page walks (0 without a TLB).
+    uint64_t getPageTableReads() const { return tlb ? tlb->getPageTableReads() : 0; }
     
 private:
     int processorId;
     Cache* l1Cache;
     Bus* bus;  // Pointer to the bus for bus transactions.
-    std::vector<Instruction> instructions;
-    int currentInstructionIndex;
+    std::unique_ptr<InstructionSource> source;
+    // The instruction being executed; valid while hasCurrent is true.
+    Instruction current;
+    bool hasCurrent = false;
+    // Instructions after `current` that localHorizon already fetched.
+    std::deque<Instruction> lookahead;
+    uint64_t currentInstructionIndex;
     // Stall counter for memory delays.
     int stallCounter;
     // Statistics counters.
-    int totalCycles;
-    int idleCycles;
-    int totalReadInstructions = 0;
-    int totalWriteInstructions = 0;
+    uint64_t totalCycles;
+    uint64_t idleCycles;
+    uint64_t totalReadInstructions = 0;
+    uint64_t totalWriteInstructions = 0;
+    // current.gap counts down the compute cycles left before its access.
+    uint64_t computeCycles = 0;
     // Helper to load instructions from the trace file.
     void loadTrace(const std::string &traceFile);
+    // Retires the current instruction and fetches the next one.
+    void advance();
+    // Makes the next instruction current: the first one localHorizon
+    // fetched ahead, else the next one from the source.
+    void fetch();
+    // Charges the current instruction and the rest of its same-block run
+    // (as reported by a pre-decoded source) in one step if they are all
+    // guaranteed hits. Returns the cycles charged, 0 if none.
+    int chargeRun(int maxCycles);
+    // Number of accesses, at most maxCycles, chargeRun would charge (the
+    // run stops before a write to a Shared block); 0 if fewer than two.
+    int runLength(int maxCycles) const;
+    // executeCycle when a store buffer is configured.
+    void executeBufferedCycle();
+    // True if a buffered store to the same word can supply this load.
+    bool forwardsFromStoreBuffer(uint32_t address) const;
+    // Performs the current atomic through the L1; returns true once done.
+    bool executeAtomic();
+    // Counts a read of a lock block (no-op for other blocks).
+    void countLockRead(uint32_t address, bool missed);
+    // Replaces current.address with its physical address. Returns false
+    // while a page walk is still in progress (one step per cycle).
+    bool translate();
+
+    // Virtual memory.
+    Tlb *tlb = nullptr;
+    bool translated = false; // current.address is already physical.
+    int walkLevel = -1;      // Next page table level to read; -1 = no walk.
+    int walkPenaltyLeft = 0;
+    uint64_t walkStart = 0;
+
+    // Store buffer: word addresses of retired, not yet performed stores.
+    std::deque<uint32_t> storeBuffer;
+    int storeBufferCapacity = 0;
+    bool drainMissPending = false; // The cache is filling for the head store.
+    uint64_t storesBuffered = 0;
+    uint64_t loadsForwarded = 0;
+    uint64_t storeStallCyclesSaved = 0;
+    uint64_t storeBufferFullStalls = 0;
+
+    // Atomics and fences.
+    uint64_t totalAtomics = 0;
+    uint64_t totalFences = 0;
+    uint64_t fenceStallCycles = 0;
+    bool atomicIssued = false;  // The current atomic's BusRdWITWr is outstanding.
+    uint64_t atomicStart = 0;
+    std::unordered_map<uint32_t, LockCounters> locks;
 
     // Add these member variables:
     bool hasWaitingInstruction = false;
@@ -0,0 +1,76 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+
+// Host-side regions whose wall time is tracked by --profile.
+enum class ProfileSection
+{
+    TraceLoad,      // Building processors and parsing their traces.
+    MainLoop,       // The whole global-clock loop.
+    BusResolve,     // Bus::resolveTransactions calls.
+    ProcessorCycle, // Processor::executeCycle calls.
+    RunAhead,       // --parallel: cores running ahead on their own threads.
+    Count
+};
+
+// Measures where host time goes during a simulation run.
+// Wall time is accumulated per section; peak RSS comes from getrusage and,
+// on Linux, host instructions/cycles/LLC misses are read through
+// perf_event_open when the kernel permits it.
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler();
+
+    // Adds the given number of nanoseconds to a section.
+    void add(ProfileSection section, uint64_t ns)
+    {
+        elapsedNs[static_cast<int>(section)] += ns;
+        calls[static_cast<int>(section)]++;
+    }
+
+    // Opens and enables the hardware counters (no-op if unavailable).
+    void startCounters();
+    // Disables the hardware counters and latches their values.
+    void stopCounters();
+
+    // Prints the host profile; simulatedCycles is the final global clock.
+    void printReport(std::ostream &out, uint64_t simulatedCycles) const;
+
+private:
+    static const int numSections = static_cast<int>(ProfileSection::Count);
+    static const int numCounters = 3; // instructions, cycles, LLC misses.
+
+    uint64_t elapsedNs[numSections];
+    uint64_t calls[numSections];
+
+    int counterFds[numCounters];
+    uint64_t counterValues[numCounters];
+    bool countersAvailable;
+};
+
+// RAII helper: charges the lifetime of the scope to one section.
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler &profiler, ProfileSection section)
+        : profiler(profiler), section(section),
+          begin(std::chrono::steady_clock::now()) {}
+
+    ~ProfileScope()
+    {
+        auto end = std::chrono::steady_clock::now();
+        profiler.add(section, std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+
+private:
+    Profiler &profiler;
+    ProfileSection section;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#endif // PROFILER_HPP
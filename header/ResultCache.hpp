@@ -0,0 +1,72 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// 64-bit hash of `size` bytes, eight at a time; `seed` chains calls.
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0);
+// Hashes a whole file in fixed-size chunks; returns false if it cannot be read.
+bool hashFile(const std::string &path, uint64_t &hash);
+
+// Everything a run's output depends on, one "<name> <value>" line per
+// input. Files enter by content hash alone, not by path or timestamp, so a
+// key changes when a file's bytes do and not when it is touched.
+class ResultKey {
+public:
+    void addValue(const std::string &name, const std::string &value);
+    // Adds the file's content hash (not its path), or "missing"; returns
+    // false in that case.
+    bool addFile(const std::string &name, const std::string &path);
+
+    const std::string &text() const { return material; }
+    // 16 hex digits naming the entry on disk.
+    std::string digest() const;
+
+private:
+    std::string material;
+};
+
+// Directory of finished runs' output (--result-cache). Each entry is one
+// file named by its key's digest holding the full key text, so a digest
+// collision reads as a miss rather than as someone else's result.
+class ResultCache {
+public:
+    explicit ResultCache(const std::string &directory);
+
+    // Returns true and fills `output` if an entry for `key` exists.
+    bool lookup(const ResultKey &key, std::string &output) const;
+    // Writes (or replaces) the entry atomically; returns false with a
+    // message on std::cerr if the directory is not writable.
+    bool store(const ResultKey &key, const std::string &output) const;
+
+    std::string entryPath(const ResultKey &key) const;
+
+private:
+    std::string directory;
+};
+
+// Copies everything written to a stream into a string while still passing
+// it through, so a run's output can be stored once it has been printed.
+class OutputRecorder : public std::streambuf {
+public:
+    explicit OutputRecorder(std::ostream &stream);
+    ~OutputRecorder();
+
+    const std::string &recorded() const { return text; }
+
+protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    std::ostream &stream;
+    std::streambuf *target;
+    std::string text;
+};
+
+#endif // RESULT_CACHE_HPP
@@ -0,0 +1,47 @@
+#ifndef SIMPOINT_HPP
+#define SIMPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TraceParser.hpp"
+
+// Knobs of the phase analysis (tools/simpoint).
+struct SimPointConfig {
+    uint64_t intervalLength = 10000; // Instructions per core per interval.
+    int maxClusters = 10;            // Largest k tried.
+    int dimensions = 15;             // Random projection width.
+    int blockBits = 5;               // Signatures count accesses per 2^b-byte block.
+    uint64_t seed = 1;
+    int restarts = 5;                // k-means runs per k; the lowest error wins.
+};
+
+// One representative interval and the fraction of all intervals it stands for.
+struct SimPoint {
+    uint64_t interval;
+    double weight;
+};
+
+struct SimPointSet {
+    uint64_t intervalLength = 0;
+    uint64_t numIntervals = 0;
+    std::vector<SimPoint> points; // Sorted by interval; weights sum to 1.
+};
+
+// Interval i covers instructions [i * L, (i + 1) * L) of every core. Its
+// signature is the random projection of its per-(core, block) access
+// frequencies onto config.dimensions dimensions.
+std::vector<std::vector<double>> intervalSignatures(const std::vector<std::vector<Instruction>> &traces,
+                                                    const SimPointConfig &config);
+
+// Clusters the signatures with k-means for k = 1..maxClusters, keeps the
+// smallest k whose BIC score reaches 90% of the best score's range, and
+// returns the interval nearest each cluster centre, weighted by cluster size.
+SimPointSet pickSimPoints(const std::vector<std::vector<double>> &signatures, const SimPointConfig &config);
+
+// Simpoint files are plain text: "interval-length <L>", "intervals <N>",
+// then one "<interval> <weight>" line per point. Errors go to std::cerr.
+bool writeSimPoints(const std::string &path, const SimPointSet &set);
+bool readSimPoints(const std::string &path, SimPointSet &set);
+
+#endif // SIMPOINT_HPP
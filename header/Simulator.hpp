@@ -0,0 +1,152 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Bus.hpp"
+#include "Cache.hpp"
+#include "Cluster.hpp"
+#include "DecodedTrace.hpp"
+#include "Directory.hpp"
+#include "Dram.hpp"
+#include "EventTrace.hpp"
+#include "L2Cache.hpp"
+#include "Prefetcher.hpp"
+#include "Processor.hpp"
+#include "Profiler.hpp"
+#include "SimPoint.hpp"
+#include "Snapshot.hpp"
+#include "Tlb.hpp"
+#include "WorkloadGenerator.hpp"
+
+// Structure for simulation configuration (defaults as on the command line).
+struct SimulationConfig {
+    std::string tracePrefix;
+    int numCores = 4; // Simulated cores (--cores); traces are <prefix>_proc<i>.trace.
+    int s = 4; // Number of set index bits.
+    int E = 2; // Associativity.
+    int b = 5; // Block bits (block size in bytes = 2^b).
+    std::string outputFilename = "output.log";
+    bool profile = false; // Report where host time goes (--profile).
+    bool useWorkload = false; // Generate instructions instead of reading traces (-w).
+    bool predecode = false;   // Load traces as same-block runs (--predecode).
+    bool genericCache = false; // Skip the compile-time cache specialisations (--generic-cache).
+    bool estimate = false;     // Functional caches and a bus queueing model, no cycle loop (--estimate).
+    WorkloadConfig workload;
+    int parallelQuantum = 0; // Cycles per quantum in parallel mode; 0 = serial loop.
+    std::vector<int> quantumSweep; // Quanta to compare against the serial loop.
+    PrefetcherKind prefetcher = PrefetcherKind::None; // L1 prefetcher (--prefetch).
+    int prefetchDegree = 1;        // Blocks fetched ahead per trigger.
+    int storeBufferEntries = 0;    // Per-core store buffer size; 0 = none.
+    int victimEntries = 0;         // Per-core victim cache lines; 0 = none.
+    bool useL2 = false;            // Shared L2 below the L1s (--l2).
+    int l2s = 0, l2E = 0, l2b = 0; // L2 geometry, same meaning as s, E, b.
+    int l2Latency = 20;            // L2 hit latency in cycles.
+    bool l2Inclusive = true;       // Back-invalidate L1 copies of L2 victims.
+    int writebackBufferEntries = 0; // Write-back buffer blocks; 0 = write-backs hold the bus.
+    ArbitrationPolicy arbitration = ArbitrationPolicy::Fifo; // Demand arbitration (--arbitration).
+    bool reportBusWait = false;    // Print per-core bus wait statistics.
+    bool useDram = false;          // DRAM timing instead of a flat 100 cycles (--dram).
+    DramConfig dram;
+    uint64_t snapshotInterval = 0; // Cycles between progress snapshots; 0 = none.
+    std::string snapshotFile = "snapshots.csv"; // Where snapshots are appended (.json/.jsonl or CSV).
+    bool useDirectory = false;     // Directory over a mesh instead of the bus (--directory).
+    DirectoryConfig directory;
+    bool useClusters = false;      // Cluster buses under a global interconnect (--clusters).
+    ClusterConfig cluster;
+    std::string simpointFile;      // Simulate only these weighted slices (--simpoints).
+    uint64_t simpointWarmup = UINT64_MAX; // Instructions per core run before each slice; max = one interval.
+    std::string eventTraceFile; // Binary event trace (--event-trace); empty = none.
+    TraceFilter eventFilter;    // Cores, addresses and cycles kept in the event trace.
+    bool useTlb = false;        // Per-core TLBs and a page mapping (--tlb).
+    TlbConfig tlb;
+    std::string resultCacheDir; // Finished runs are stored and replayed here (--result-cache); empty = off.
+    bool refreshResultCache = false; // Re-run and overwrite the stored entry (--refresh-result-cache).
+};
+
+// Returns false (with a message on std::cerr) if options conflict.
+bool checkSimulationConfig(const SimulationConfig &config);
+
+// Owns the bus, caches and processors of one simulated system and drives
+// the global clock.
+class Simulator {
+public:
+    // Builds the system and loads every core's instruction stream.
+    explicit Simulator(const SimulationConfig &config, Profiler *profiler = nullptr);
+    // Same, but core i runs sources[i] (taken over) instead of the
+    // configured trace or workload.
+    Simulator(const SimulationConfig &config, const std::vector<InstructionSource*> &sources,
+              Profiler *profiler = nullptr);
+    ~Simulator();
+
+    // Runs the cycle-by-cycle loop until every core has finished.
+    void run();
+    // Runs at most `cycles` cycles of the same loop; returns true once
+    // every core has finished and the bus is idle.
+    bool step(uint64_t cycles);
+    bool isFinished() const;
+    // Lets cores whose source ran dry pick up instructions appended to it
+    // since (see BatchSource).
+    void resume();
+
+    // Same results as run(), with each Processor/Cache pair on its own
+    // host thread. Whenever the bus is idle, the cores run on their threads
+    // through the cycles (up to `quantum`) before any of them needs the bus
+    // again: compute gaps and L1 hits. All other cycles run serially.
+    void runParallel(int quantum);
+
+    // Appends a snapshot to `writer` every `interval` global cycles, and
+    // once more when the run ends.
+    void setSnapshots(SnapshotWriter *writer, uint64_t interval);
+
+    // Gives core i sources[i] (taken over) to run next; caches and
+    // statistics carry over, so run() can be called again.
+    void setSources(const std::vector<InstructionSource*> &sources);
+
+    uint64_t getGlobalClock() const { return globalClock; }
+    const std::vector<Processor*> &getProcessors() const { return processors; }
+    const std::vector<Cache*> &getCaches() const { return caches; }
+    Bus &getBus() { return *bus; }
+    // The bus core i's cache is attached to: its cluster's bus, or the bus.
+    const Bus &getCoreBus(int core) const { return clustered ? *clustered->getClusterBus(core) : *bus; }
+    // The clustered topology, or nullptr if there is one bus.
+    const ClusteredBus *getClusteredBus() const { return clustered; }
+    // The directory backend, or nullptr if the snooping bus is used.
+    const Directory *getDirectory() const { return directory; }
+    // The shared L2, or nullptr if none was configured.
+    const L2Cache *getL2() const { return l2.get(); }
+    // The DRAM model, or nullptr if memory has a flat latency.
+    const Dram *getDram() const { return dram.get(); }
+    // Core i's TLB, or nullptr if addresses are not translated.
+    const Tlb *getTlb(int core) const { return tlbs.empty() ? nullptr : tlbs[core].get(); }
+    const PageMapper *getPageMapper() const { return pageMapper.get(); }
+
+private:
+    int numCores;
+    std::unique_ptr<Bus> bus;
+    Directory *directory = nullptr; // Same object as bus in directory mode.
+    ClusteredBus *clustered = nullptr; // Same object as bus in cluster mode.
+    std::unique_ptr<L2Cache> l2;
+    std::unique_ptr<Dram> dram;
+    std::unique_ptr<PageMapper> pageMapper;
+    std::vector<std::unique_ptr<Tlb>> tlbs;
+    std::vector<Processor*> processors;
+    std::vector<Cache*> caches;
+    Profiler *prof;
+    uint64_t globalClock = 0;
+    SnapshotWriter *snapshots = nullptr;
+    uint64_t snapshotInterval = 0;
+    uint64_t nextSnapshot = UINT64_MAX; // The loop only compares against this.
+    void takeSnapshot();
+    // One global cycle; returns true if no core had work left.
+    bool tick();
+    // If every unfinished core is in a compute gap or a run of guaranteed
+    // hits (pre-decoded traces) and the bus is idle, jumps the clock to the
+    // first cycle where something can reach the bus (at most `limit`
+    // cycles, stopping at the next snapshot). Returns the cycles skipped.
+    uint64_t skipLocalWork(uint64_t limit);
+};
+
+#endif // SIMULATOR_HPP
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Processor;
+class Cache;
+class Bus;
+
+// Appends periodic progress snapshots of a running simulation to a file
+// (--snapshot-interval). Files ending in .json or .jsonl get one JSON
+// object per snapshot; anything else gets CSV with one row per core.
+class SnapshotWriter {
+public:
+    // Opens the file for appending, so snapshots of several runs can share
+    // it; a CSV header is written only if the file is empty. Check isOpen()
+    // afterwards.
+    explicit SnapshotWriter(const std::string &path);
+
+    bool isOpen() const { return out.is_open(); }
+
+    // Records every core's progress at global cycle `clock`. Each snapshot
+    // is flushed so the file can be watched while the run continues.
+    void write(uint64_t clock, const std::vector<Processor *> &processors,
+               const std::vector<Cache *> &caches, const Bus &bus);
+
+private:
+    std::ofstream out;
+    bool json;
+};
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,132 @@
+#ifndef TLB_HPP
+#define TLB_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// How virtual pages are placed in physical memory (selected with --tlb).
+enum class PageMapping { Identity, Random, Coloring };
+
+struct TlbConfig {
+    PageMapping mapping = PageMapping::Identity;
+    int entries = 64;     // Per-core TLB entries.
+    int ways = 4;         // TLB associativity.
+    int pageBits = 12;    // Page size is 2^pageBits bytes.
+    int levels = 2;       // Page table levels read by a walk.
+    int missPenalty = 10; // Walker cycles on top of the page table reads.
+    uint64_t seed = 1;    // Random page allocation.
+};
+
+// Parses "identity|random|color[:key=value,...]" into config.
+// Returns false (with a message on std::cerr) if the spec is malformed.
+bool parseTlbSpec(const std::string &spec, TlbConfig &config);
+const char *pageMappingName(PageMapping mapping);
+
+// Physical address of the radix page table. Data frames are allocated
+// below it (except under the identity mapping).
+static const uint32_t PAGE_TABLE_BASE = 0xF0000000;
+
+// Virtual -> physical page placement, shared by all cores (the traces are
+// threads of one address space). Frames are allocated on first touch.
+class PageMapper {
+public:
+    virtual ~PageMapper() {}
+    // Returns the frame holding the given virtual page.
+    virtual uint32_t frameOf(uint32_t page) = 0;
+    uint64_t getPagesMapped() const { return frames.size(); }
+
+    // colorBits: bits of the frame number that also index L1 sets.
+    static PageMapper *create(const TlbConfig &config, int colorBits);
+
+protected:
+    std::unordered_map<uint32_t, uint32_t> frames;
+};
+
+// Physical address = virtual address.
+class IdentityMapper : public PageMapper {
+public:
+    uint32_t frameOf(uint32_t page) override;
+};
+
+// Each new page gets a uniformly random free frame, so pages that are
+// contiguous in virtual memory can collide in the cache.
+class RandomMapper : public PageMapper {
+public:
+    RandomMapper(int pageBits, uint64_t seed);
+    uint32_t frameOf(uint32_t page) override;
+
+private:
+    uint32_t numFrames;
+    std::mt19937_64 rng;
+    std::unordered_set<uint32_t> used;
+};
+
+// Page coloring: each new page gets the next free frame of the same color
+// (the frame bits that index L1 sets) as its virtual page, so virtually
+// contiguous data keeps spreading evenly over the sets.
+class ColoringMapper : public PageMapper {
+public:
+    ColoringMapper(int pageBits, int colorBits);
+    uint32_t frameOf(uint32_t page) override;
+
+private:
+    int colorBits;
+    uint32_t framesPerColor;
+    std::vector<uint32_t> nextFrame; // Per color.
+};
+
+// A set-associative, LRU translation buffer for one core. Misses are
+// filled by a walk whose page table reads the Processor performs through
+// its L1 (see pteAddress).
+class Tlb {
+public:
+    Tlb(const TlbConfig &config, PageMapper *mapper);
+
+    // Translates vaddr if its page is cached; counts the lookup and any miss.
+    bool lookup(uint32_t vaddr, uint32_t &paddr);
+    // True if lookup would hit, with the translation it would return (no
+    // statistics or LRU update).
+    bool contains(uint32_t vaddr, uint32_t &paddr) const;
+    // Physical address of the page table entry read at walk level `level`
+    // (0 = root) for vaddr.
+    uint32_t pteAddress(uint32_t vaddr, int level) const;
+    // Completes a walk: maps the page if needed, caches the translation and
+    // returns the physical address. walkCycles is the walk's duration.
+    uint32_t fill(uint32_t vaddr, uint64_t walkCycles);
+
+    int getLevels() const { return config.levels; }
+    int getMissPenalty() const { return config.missPenalty; }
+
+    // Statistics.
+    uint64_t getLookups() const { return lookups; }
+    uint64_t getMisses() const { return misses; }
+    uint64_t getWalkCycles() const { return walkCycles; }
+    void countPageTableRead() { pageTableReads++; }
+    uint64_t getPageTableReads() const { return pageTableReads; }
+
+private:
+    struct Entry {
+        bool valid;
+        uint32_t page;
+        uint32_t frame;
+        uint64_t lastUse;
+    };
+    TlbConfig config;
+    PageMapper *mapper;
+    int numSets;
+    std::vector<Entry> entries; // numSets x ways.
+    std::vector<int> levelBits;       // VPN bits indexed at each level.
+    std::vector<uint32_t> levelBase;  // Physical base of each level's tables.
+    uint64_t useClock = 0;
+
+    uint64_t lookups = 0;
+    uint64_t misses = 0;
+    uint64_t walkCycles = 0;
+    uint64_t pageTableReads = 0;
+};
+
+#endif // TLB_HPP
@@ -5,16 +5,24 @@
 #include <vector>
 #include <cstdint>
 
-enum class OperationType { READ, WRITE };
+// ATOMIC is a read-modify-write of one word (performed with the block held
+// Modified); FENCE orders memory and has no address.
+enum class OperationType { READ, WRITE, ATOMIC, FENCE };
 
 struct Instruction {
     OperationType op;
-    uint32_t address;
+    uint32_t address; // 0 for fences.
+    uint32_t gap = 0; // Non-memory (compute) cycles before this access.
 };
 
 class TraceParser {
 public:
     // Parse the given trace file into a vector of Instructions.
+    // Besides "R <addr>" and "W <addr>" lines, a trace may hold compute
+    // gaps: "C <cycles>" records, and/or an optional decimal third field on
+    // an access ("R <addr> <cycles>"). Both add to the gap of the next
+    // access; a gap after the last access is dropped. "A <addr>" is an
+    // atomic read-modify-write and "F" a fence; both may carry gaps too.
     static std::vector<Instruction> parseTraceFile(const std::string &filename);
 };
 
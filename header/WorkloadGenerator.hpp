@@ -0,0 +1,67 @@
+#ifndef WORKLOAD_GENERATOR_HPP
+#define WORKLOAD_GENERATOR_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "InstructionSource.hpp"
+
+// Built-in synthetic access patterns.
+enum class WorkloadKind {
+    Stride,       // Strided scan over the footprint.
+    Uniform,      // Uniformly random words in the footprint.
+    Zipf,         // Zipfian-popular words in the footprint.
+    ProdCons,     // Even cores write a shared buffer that odd cores read.
+    Migratory,    // Cores take turns read-modify-writing shared objects.
+    LockPingPong  // Cores spin on, acquire and release one shared lock word.
+};
+
+// Knobs shared by all generators (selected with -w kind:key=value,...).
+struct WorkloadConfig {
+    WorkloadKind kind = WorkloadKind::Uniform;
+    std::string spec;           // The original -w argument, for reporting.
+    uint64_t count = 1000000;   // Instructions per core.
+    uint32_t footprint = 65536; // Bytes touched per region.
+    uint32_t stride = 4;        // Bytes between consecutive scan accesses.
+    double share = 0.0;         // Fraction of accesses to the shared region
+                                // (prodcons, migratory and lock default to 0.25).
+    double writeRatio = 0.3;    // Fraction of accesses that are writes.
+    double zipfAlpha = 0.99;    // Skew of the zipfian distribution.
+    uint32_t gap = 0;           // Compute cycles before every access.
+    bool atomic = false;        // lock: acquire with an atomic RMW instead of a write.
+    uint64_t seed = 1;
+};
+
+// Parses "kind[:key=value,...]" into config.
+// Returns false (with a message on std::cerr) if the spec is malformed.
+bool parseWorkloadSpec(const std::string &spec, WorkloadConfig &config);
+
+// Instruction stream for one core, generated on the fly.
+class SyntheticSource : public InstructionSource {
+public:
+    SyntheticSource(const WorkloadConfig &config, int coreId);
+
+    bool next(Instruction &inst) override;
+    uint64_t size() const override { return config.count; }
+
+private:
+    WorkloadConfig config;
+    int coreId;
+    uint64_t produced;
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> unit;
+
+    uint32_t privateBase; // Start of this core's private region.
+    uint32_t sharedBase;  // Start of the region shared by all cores.
+    uint32_t words;       // Footprint in 4-byte words.
+    uint64_t cursor;      // Position within the pattern (scan index, phase, ...).
+    std::vector<double> zipfCdf; // Cumulative popularity, Zipf only.
+
+    bool chance(double p) { return unit(rng) < p; }
+    uint32_t randomWord() { return static_cast<uint32_t>(rng() % words) * 4; }
+    uint32_t zipfWord();
+    OperationType randomOp() { return chance(config.writeRatio) ? OperationType::WRITE : OperationType::READ; }
+};
+
+#endif // WORKLOAD_GENERATOR_HPP
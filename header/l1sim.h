@@ -0,0 +1,110 @@
+#ifndef L1SIM_H
+#define L1SIM_H
+
+/*
+ * libl1sim: the simulator as a library, behind a C ABI.
+ *
+ *   l1sim *sim = l1sim_create(6, 2, 5, 4);
+ *   l1sim_set_option(sim, "prefetch", "stride");   // optional, before feeding
+ *   l1sim_feed(sim, 0, accesses, count);          // any number of batches
+ *   l1sim_run(sim);                               // or l1sim_step(sim, n)
+ *   l1sim_get_core_stats(sim, 0, &stats, sizeof(stats));
+ *   l1sim_destroy(sim);
+ *
+ * Functions returning int return 0 on success and -1 on error; the
+ * message is then available from l1sim_last_error(). Handles are
+ * independent, so different threads may drive different handles.
+ *
+ * Option errors are collected by redirecting the process-wide std::cerr
+ * while l1sim_set_option() runs, and while the first feed, load or step
+ * checks the options. Anything another thread writes to std::cerr during
+ * such a call is taken as that handle's error message and is not printed.
+ *
+ * ABI stability: the handle is opaque, and the statistics structs only
+ * ever grow at the end. Callers pass sizeof() of the struct they were
+ * compiled against, and only that many bytes are written.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define L1SIM_API __attribute__((visibility("default")))
+#else
+#define L1SIM_API
+#endif
+
+#define L1SIM_API_VERSION 1
+
+typedef struct l1sim l1sim;
+
+enum { L1SIM_READ = 0, L1SIM_WRITE = 1, L1SIM_ATOMIC = 2, L1SIM_FENCE = 3 };
+
+/* One memory access, as in a trace line. */
+typedef struct l1sim_access {
+    uint32_t address;
+    uint8_t op; /* L1SIM_READ, L1SIM_WRITE, L1SIM_ATOMIC or L1SIM_FENCE (address ignored) */
+} l1sim_access;
+
+typedef struct l1sim_core_stats {
+    uint64_t instructions;       /* Fed to the core so far. */
+    uint64_t retired;            /* Completed so far. */
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t execution_cycles;   /* "Total Execution Cycles" in the report. */
+    uint64_t idle_cycles;
+    uint64_t cache_misses;
+    uint64_t cache_evictions;
+    uint64_t writebacks;
+    uint64_t bus_invalidations;
+    uint64_t data_traffic_bytes;
+} l1sim_core_stats;
+
+typedef struct l1sim_bus_stats {
+    uint64_t cycles;             /* Global clock. */
+    uint64_t transactions;
+    uint64_t traffic_bytes;
+} l1sim_bus_stats;
+
+L1SIM_API int l1sim_api_version(void);
+
+/* Same meaning as -s, -E, -b and --cores; returns NULL if out of range. */
+L1SIM_API l1sim *l1sim_create(int s, int E, int b, int cores);
+L1SIM_API void l1sim_destroy(l1sim *sim);
+/* Message of the last failed call on this handle ("" if none). */
+L1SIM_API const char *l1sim_last_error(const l1sim *sim);
+
+/*
+ * Sets a model option by its command-line name without the dashes, e.g.
+ * ("l2", "9,8,6"), ("dram", "open:banks=16"), ("tlb", "random"). Supported:
+ * prefetch, prefetch-degree, store-buffer, victim, l2, l2-latency,
+ * l2-noninclusive, dram, writeback-buffer, arbitration, directory, tlb and
+ * generic-cache (flags ignore value). Only allowed before the first feed,
+ * load or step.
+ */
+L1SIM_API int l1sim_set_option(l1sim *sim, const char *name, const char *value);
+
+/* Appends instructions to a core's stream. Batches may be fed while the
+ * simulation is in progress; a core that ran dry picks them up. */
+L1SIM_API int l1sim_feed(l1sim *sim, int core, const l1sim_access *accesses, size_t count);
+/* Appends every instruction of a trace file. */
+L1SIM_API int l1sim_load_trace(l1sim *sim, int core, const char *path);
+
+/* Simulates at most `cycles` cycles. Returns 1 once all fed instructions
+ * have completed and the bus is idle, 0 if work remains, -1 on error. */
+L1SIM_API int l1sim_step(l1sim *sim, uint64_t cycles);
+/* Simulates until all fed instructions have completed. */
+L1SIM_API int l1sim_run(l1sim *sim);
+
+L1SIM_API int l1sim_get_core_stats(l1sim *sim, int core, l1sim_core_stats *stats, size_t size);
+L1SIM_API int l1sim_get_bus_stats(l1sim *sim, l1sim_bus_stats *stats, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L1SIM_H */
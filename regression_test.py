@@ -0,0 +1,271 @@
+#!/usr/bin/env python3
+"""
+Golden-output and performance regression suite for L1simulate.
+
+Runs every header/Test_cases/N_* set and trace_files/app1_test under several
+cache configurations, plus the targeted runs in EXTRA_RUNS, and compares the
+full statistics against the stored outputs in regression/golden. Generated workloads are run with --parallel at
+several quanta, whose output must equal the serial loop's. A few synthetic
+workloads are then timed and
+their throughput (simulated instructions per host second) is compared
+against regression/perf_baseline.json.
+
+Usage:
+    python3 regression_test.py                 # check goldens and throughput
+    python3 regression_test.py --update        # rewrite goldens from this build
+    python3 regression_test.py --update-perf   # rewrite the throughput baseline
+    python3 regression_test.py --threshold 0.3 # allowed throughput drop (default 0.25)
+    python3 regression_test.py --no-perf       # skip the throughput check
+"""
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+SIM_CMD = os.path.abspath("./L1simulate")
+TEST_DIR = os.path.join("header", "Test_cases")
+APP_PREFIX = os.path.join("trace_files", "app1_test")
+GOLDEN_DIR = os.path.join("regression", "golden")
+TRACE_DIR = os.path.join("regression", "traces")
+PERF_BASELINE = os.path.join("regression", "perf_baseline.json")
+PERF_HISTORY = os.path.join("regression", "perf_history.csv")
+
+# Same four cache configurations as generate_and_plot.py.
+PARAMS = [
+    ("s6E2b5", {"s": 6, "E": 2, "b": 5}),
+    ("s7E2b5", {"s": 7, "E": 2, "b": 5}),
+    ("s6E2b6", {"s": 6, "E": 2, "b": 6}),
+    ("s6E4b5", {"s": 6, "E": 4, "b": 5}),
+]
+
+# Runs outside the PARAMS sweep: (golden name, options). A -t prefix names a
+# trace set in regression/traces.
+EXTRA_RUNS = [
+    # An atomic whose block comes back from the victim cache Shared must still
+    # invalidate the other core's copy.
+    ("victim_atomic", ["-t", "victim_atomic", "-s", "6", "-E", "1", "-b", "5", "--victim", "2"]),
+]
+
+# Long generated runs (30000 accesses per core) on the default cache, alone
+# and under each optional backend, so that effects which only build up over
+# many misses (row buffer scheduling, directory and mesh contention, lock
+# hand-offs, parallel windows) are pinned down too.
+LONG_ZIPF = ["-w", "zipf:count=30000,share=0.2,seed=11"]
+LONG_LOCK = ["-w", "lock:count=30000,atomic=1,seed=11"]
+EXTRA_RUNS += [
+    ("long_zipf", LONG_ZIPF),
+    ("long_lock", LONG_LOCK),
+    ("long_lock_victim", LONG_LOCK + ["--victim", "4"]),
+    ("long_zipf_victim", LONG_ZIPF + ["--victim", "4"]),
+    ("long_zipf_dram_open", LONG_ZIPF + ["--dram", "open"]),
+    ("long_zipf_dram_closed_age", LONG_ZIPF + ["--dram", "closed", "--arbitration", "age"]),
+    ("long_zipf_directory_full", LONG_ZIPF + ["--directory", "full"]),
+    ("long_lock_directory_limited", LONG_LOCK + ["--directory", "limited"]),
+    ("long_zipf_clusters", LONG_ZIPF + ["--clusters", "2"]),
+    ("long_zipf_l2", LONG_ZIPF + ["--l2", "8,4,6"]),
+    ("long_zipf_tlb", LONG_ZIPF + ["--tlb", "random"]),
+    ("long_zipf_prefetch", LONG_ZIPF + ["--prefetch", "stream"]),
+    ("long_migratory_store_buffer", ["-w", "migratory:count=30000,seed=11", "--store-buffer", "8"]),
+    ("long_prodcons_writeback_buffer", ["-w", "prodcons:count=30000,seed=11", "--writeback-buffer", "4"]),
+    ("long_zipf_gap_parallel", ["-w", "zipf:count=30000,share=0.2,gap=2,seed=11", "--parallel", "256"]),
+]
+
+# Synthetic workloads timed for the throughput check.
+PERF_WORKLOADS = [
+    ("uniform", "uniform:count=50000,share=0.1"),
+    ("lock", "lock:count=50000,share=0.2"),
+]
+PERF_REPEATS = 3
+
+# Workloads (and extra options) whose --parallel output must match the
+# serial loop's at every quantum.
+PARALLEL_RUNS = [
+    ("zipf:count=20000,share=0.1,gap=2,seed=1", []),
+    ("lock:count=20000,atomic=1,seed=1", ["--victim", "2"]),
+]
+PARALLEL_QUANTA = [1, 64, 1000]
+DEFAULT_THRESHOLD = 0.25
+
+
+def stage_cases(work_dir):
+    """Copies each trace set into work_dir as <name>_proc<i>.trace; returns the names."""
+    cases = []
+    prefixes = set()
+    for fname in os.listdir(TEST_DIR):
+        m = re.match(r"^(\d+)_[0-3]\.trace$", fname)
+        if m:
+            prefixes.add(int(m.group(1)))
+    for n in sorted(prefixes):
+        name = f"tc_{n}"
+        for i in range(4):
+            src = os.path.join(TEST_DIR, f"{n}_{i}.trace")
+            dst = os.path.join(work_dir, f"{name}_proc{i}.trace")
+            if os.path.exists(src):
+                shutil.copyfile(src, dst)
+            else:
+                open(dst, "w").close()
+        cases.append(name)
+
+    for i in range(4):
+        shutil.copyfile(f"{APP_PREFIX}_proc{i}.trace",
+                        os.path.join(work_dir, f"app1_test_proc{i}.trace"))
+    cases.append("app1_test")
+
+    for fname in os.listdir(TRACE_DIR):
+        shutil.copyfile(os.path.join(TRACE_DIR, fname), os.path.join(work_dir, fname))
+    return cases
+
+
+def run_sim(args, cwd=None):
+    # A replayed result would hide both output and throughput changes.
+    env = {k: v for k, v in os.environ.items() if k != "L1SIM_RESULT_CACHE"}
+    proc = subprocess.run([SIM_CMD] + args, capture_output=True, text=True, cwd=cwd, env=env)
+    if proc.returncode != 0:
+        raise RuntimeError(f"{' '.join(args)} exited with {proc.returncode}:\n{proc.stderr}")
+    return proc.stdout
+
+
+def compare_golden(name, output, update):
+    """Checks output against regression/golden/<name>.txt (or rewrites it); returns True on a mismatch."""
+    golden = os.path.join(GOLDEN_DIR, f"{name}.txt")
+    if update:
+        with open(golden, "w") as f:
+            f.write(output)
+        return False
+    if not os.path.exists(golden):
+        print(f"MISSING {name}: no golden output (run with --update)")
+        return True
+    with open(golden) as f:
+        expected = f.read()
+    if output != expected:
+        print(f"FAIL    {name}")
+        show_diff(expected, output)
+        return True
+    return False
+
+
+def check_goldens(update):
+    """Returns the number of mismatching runs."""
+    os.makedirs(GOLDEN_DIR, exist_ok=True)
+    failures = 0
+    checked = 0
+    with tempfile.TemporaryDirectory() as work_dir:
+        # Running inside work_dir keeps "Trace Prefix:" host independent.
+        for case in stage_cases(work_dir):
+            for label, p in PARAMS:
+                output = run_sim(["-t", case, "-s", str(p["s"]), "-E", str(p["E"]), "-b", str(p["b"])],
+                                 cwd=work_dir)
+                checked += 1
+                failures += compare_golden(f"{case}_{label}", output, update)
+        for name, args in EXTRA_RUNS:
+            checked += 1
+            failures += compare_golden(name, run_sim(args, cwd=work_dir), update)
+    action = "Updated" if update else "Checked"
+    print(f"{action} {checked} golden outputs, {failures} failed")
+    return failures
+
+
+def show_diff(expected, actual, limit=10):
+    shown = 0
+    for i, (e, a) in enumerate(zip(expected.splitlines(), actual.splitlines())):
+        if e != a:
+            print(f"        line {i + 1}: expected '{e}', got '{a}'")
+            shown += 1
+            if shown == limit:
+                break
+    if expected.count("\n") != actual.count("\n"):
+        print(f"        expected {expected.count(chr(10))} lines, got {actual.count(chr(10))}")
+
+
+def check_parallel():
+    """Returns the number of (workload, quantum) runs that differ from serial."""
+    failures = 0
+    checked = 0
+    for spec, extra in PARALLEL_RUNS:
+        args = ["-w", spec] + extra
+        expected = run_sim(args)
+        for quantum in PARALLEL_QUANTA:
+            output = run_sim(args + ["--parallel", str(quantum)])
+            checked += 1
+            if output != expected:
+                print(f"FAIL    {' '.join(args)} --parallel {quantum}")
+                show_diff(expected, output)
+                failures += 1
+    print(f"Checked {checked} parallel runs against the serial loop, {failures} failed")
+    return failures
+
+
+def measure_throughput(spec):
+    """Best-of-N simulated instructions per host second for one workload."""
+    best, best_seconds = 0.0, 0.0
+    for _ in range(PERF_REPEATS):
+        start = time.perf_counter()
+        output = run_sim(["-w", spec, "-s", "6", "-E", "2", "-b", "5"])
+        seconds = time.perf_counter() - start
+        instructions = sum(int(x) for x in re.findall(r"Total Instructions:\s*(\d+)", output))
+        if instructions / seconds > best:
+            best, best_seconds = instructions / seconds, seconds
+    return best, best_seconds
+
+
+def check_perf(update, threshold):
+    """Returns the number of workloads whose throughput regressed."""
+    baseline = {}
+    if os.path.exists(PERF_BASELINE):
+        with open(PERF_BASELINE) as f:
+            baseline = json.load(f)
+
+    failures = 0
+    results = {}
+    new_history = not os.path.exists(PERF_HISTORY)
+    with open(PERF_HISTORY, "a") as history:
+        if new_history:
+            history.write("timestamp,workload,seconds,instructions_per_second\n")
+        for name, spec in PERF_WORKLOADS:
+            throughput, seconds = measure_throughput(spec)
+            results[name] = round(throughput)
+            history.write(f"{int(time.time())},{name},{seconds:.3f},{throughput:.0f}\n")
+            line = f"{name}: {seconds:.3f} s, {throughput:,.0f} instructions/s"
+            if not update and name in baseline:
+                change = throughput / baseline[name] - 1.0
+                line += f" ({change:+.1%} vs baseline)"
+                if change < -threshold:
+                    line = "FAIL    " + line
+                    failures += 1
+            print(line)
+
+    if update:
+        with open(PERF_BASELINE, "w") as f:
+            json.dump(results, f, indent=2)
+            f.write("\n")
+        print(f"Wrote {PERF_BASELINE}")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="L1simulate regression suite")
+    parser.add_argument("--update", action="store_true", help="rewrite golden outputs")
+    parser.add_argument("--update-perf", action="store_true", help="rewrite the throughput baseline")
+    parser.add_argument("--no-perf", action="store_true", help="skip the throughput check")
+    parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD,
+                        help="allowed fractional throughput drop (default %(default)s)")
+    args = parser.parse_args()
+
+    if not os.path.exists(SIM_CMD):
+        print(f"ERROR: Simulator not found at '{SIM_CMD}' (run make first)")
+        sys.exit(1)
+
+    failures = check_goldens(args.update)
+    failures += check_parallel()
+    if not args.no_perf:
+        failures += check_perf(args.update_perf, args.threshold)
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,14 +1,60 @@
 // Bus.cpp
 #include "Bus.hpp"
 #include "Cache.hpp"
+#include "L2Cache.hpp"
+#include "Dram.hpp"
+#include "Cluster.hpp"
+#include "EventTrace.hpp"
+#include <algorithm>
 #include <iostream>
 
+bool parseArbitrationPolicy(const std::string &name, ArbitrationPolicy &policy)
+{
+    if (name == "fifo")
+        policy = ArbitrationPolicy::Fifo;
+    else if (name == "rr")
+        policy = ArbitrationPolicy::RoundRobin;
+    else if (name == "priority")
+        policy = ArbitrationPolicy::FixedPriority;
+    else if (name == "age")
+        policy = ArbitrationPolicy::AgeWeighted;
+    else
+        return false;
+    return true;
+}
+
+const char *arbitrationPolicyName(ArbitrationPolicy policy)
+{
+    switch (policy)
+    {
+    case ArbitrationPolicy::Fifo:
+        return "fifo";
+    case ArbitrationPolicy::RoundRobin:
+        return "round-robin";
+    case ArbitrationPolicy::FixedPriority:
+        return "fixed priority";
+    case ArbitrationPolicy::AgeWeighted:
+        return "age-weighted";
+    }
+    return "unknown";
+}
+
+//------------------------------------------------------------------
 Bus::Bus()
     : totalBusTransactions(0),
       pendingBusWr(false),
       pendingBusWrCycles(0),
       pendingBusWrSourceId(-1)
 {
+    setArbitration(ArbitrationPolicy::Fifo, 4);
+}
+
+void Bus::setArbitration(ArbitrationPolicy policy, int numCores)
+{
+    arbitration = policy;
+    grants.assign(numCores, 0);
+    totalWait.assign(numCores, 0);
+    maxWait.assign(numCores, 0);
 }
 
 void Bus::addTransaction(const BusTransaction &transaction)
@@ -29,6 +75,7 @@ void Bus::addTransaction(const BusTransaction &transaction)
     // }
     
     ++totalBusTransactions;
+    TRACE_EVENT(Bus, BusQueue, transaction.sourceProcessorId, transaction.address, transaction.type);
     switch (transaction.type)
     {
         case BusTransactionType::BusUpgr:
@@ -52,7 +99,341 @@ void Bus::addTransaction(const BusTransaction &transaction)
                 busInvalidations++;
             }
             transactions.push_back(transaction);
+            transactions.back().issueCycle = cycle;
+    }
+}
+
+bool Bus::addPrefetch(const BusTransaction &transaction)
+{
+    if (prefetchQueue.size() >= maxPrefetchQueue)
+        return false;
+    if (prefetchActive && activePrefetch.address == transaction.address &&
+        activePrefetch.sourceProcessorId == transaction.sourceProcessorId)
+        return false;
+    for (const auto &tx : prefetchQueue)
+    {
+        if (tx.address == transaction.address && tx.sourceProcessorId == transaction.sourceProcessorId)
+            return false;
+    }
+    prefetchQueue.push_back(transaction);
+    return true;
+}
+
+bool Bus::cancelPrefetch(uint32_t blockAddress, int sourceProcessorId)
+{
+    for (size_t i = 0; i < prefetchQueue.size(); ++i)
+    {
+        if (prefetchQueue[i].address == blockAddress && prefetchQueue[i].sourceProcessorId == sourceProcessorId)
+        {
+            prefetchQueue.erase(prefetchQueue.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Bus::demandWaiting(const std::vector<Cache *> &caches) const
+{
+    if (!upgradeQueue.empty() || !writebackQueue.empty())
+        return true;
+    if (transactions.empty())
+        return false;
+    const BusTransaction &head = transactions.front();
+    uint32_t blockMask = ~static_cast<uint32_t>(caches[0]->getBlockSizeBytes() - 1);
+    return head.type != BusTransactionType::BusRd || head.sourceProcessorId != activePrefetch.sourceProcessorId ||
+           (head.address & blockMask) != activePrefetch.address;
+}
+
+void Bus::startPrefetch(const std::vector<Cache *> &caches)
+{
+    activePrefetch = prefetchQueue.front();
+    prefetchQueue.erase(prefetchQueue.begin());
+    // Snooped as it is issued, like a demand BusRd, so no holder changes
+    // state while the fill is in flight.
+    for (auto c : caches)
+    {
+        if (c->getProcessorId() != activePrefetch.sourceProcessorId)
+            c->handleBusTransaction(activePrefetch);
+    }
+    if (writebackBufferSize > 0)
+        absorbWritebacks(caches);
+    // A Modified holder just queued its write-back, which takes the bus
+    // first; the prefetch is issued again once the bus is free.
+    if (!writebackQueue.empty())
+    {
+        prefetchQueue.insert(prefetchQueue.begin(), activePrefetch);
+        return;
+    }
+
+    // Another cache holding the block supplies it, as for a demand BusRd;
+    // otherwise the write-back buffer or memory.
+    int n = caches[0]->getBlockSizeBytes() / 4;
+    int delay = -1;
+    activePrefetchShared = false;
+    for (auto c : caches)
+    {
+        if (c->getProcessorId() != activePrefetch.sourceProcessorId && c->hasBlock(activePrefetch.address))
+        {
+            delay = 2 * n + (c->is_writing_to_mem ? writebackDuration() : 0);
+            activePrefetchShared = true;
+            break;
+        }
+    }
+    if (delay < 0 && writebackBufferSize > 0 &&
+        writebackBufferHolds(activePrefetch.address, caches[0]->getBlockSizeBytes()))
+    {
+        delay = 2 * n;
+        writebackBufferHits++;
+    }
+    if (delay < 0)
+        delay = fetchLatency(activePrefetch.address, caches);
+    prefetchActive = true;
+    prefetchCycles = delay;
+    ++totalBusTransactions;
+    ++prefetchTransactions;
+}
+
+void Bus::completePrefetch(const std::vector<Cache *> &caches)
+{
+    for (auto cache : caches)
+    {
+        if (cache->getProcessorId() == activePrefetch.sourceProcessorId)
+            cache->installPrefetch(activePrefetch.address, activePrefetchShared);
+    }
+}
+
+//------------------------------------------------------------------
+int Bus::memoryAccess(uint32_t address, bool isWrite, int after)
+{
+    return dram ? dram->access(address, isWrite, cycle + after) : memoryLatency;
+}
+
+int Bus::fetchLatency(uint32_t address, const std::vector<Cache *> &caches)
+{
+    if (!l2)
+        return memoryAccess(address, false);
+    bool hit = l2->access(address, false, backInvalidations, l2Writebacks);
+    int evict = writeL2Victims(caches);
+    return l2->getHitLatency() + evict + (hit ? 0 : memoryAccess(address, false, evict));
+}
+
+int Bus::writebackLatency(uint32_t address, const std::vector<Cache *> &caches)
+{
+    if (!l2)
+        return memoryAccess(address, true);
+    l2->access(address, true, backInvalidations, l2Writebacks);
+    return l2->getHitLatency() + writeL2Victims(caches);
+}
+
+int Bus::writeL2Victims(const std::vector<Cache *> &caches)
+{
+    applyBackInvalidations(caches);
+    int cycles = 0;
+    for (uint32_t block : l2Writebacks)
+        cycles += memoryAccess(block, true, cycles);
+    l2Writebacks.clear();
+    return cycles;
+}
+
+int Bus::writebackDuration() const
+{
+    if (l2)
+        return l2->getHitLatency();
+    return dram ? dram->rowMissLatency() : memoryLatency;
+}
+
+//------------------------------------------------------------------
+// Write-back buffer.
+void Bus::absorbWritebacks(const std::vector<Cache *> &caches)
+{
+    int blockMask = ~(caches[0]->getBlockSizeBytes() - 1);
+    while (!writebackQueue.empty() && static_cast<int>(writebackBuffer.size()) < writebackBufferSize)
+    {
+        BusTransaction wb = writebackQueue.front();
+        writebackQueue.erase(writebackQueue.begin());
+        wb.address &= blockMask;
+        writebackBuffer.push_back(wb);
+        absorbedWritebacks++;
+        // The writer no longer waits on memory.
+        bool stillQueued = false;
+        for (const auto &tx : writebackQueue)
+            stillQueued |= (tx.sourceProcessorId == wb.sourceProcessorId);
+        for (auto cache : caches)
+        {
+            if (cache->getProcessorId() == wb.sourceProcessorId && !stillQueued &&
+                !(pendingBusWr && pendingBusWrSourceId == wb.sourceProcessorId))
+            {
+                cache->is_writing_to_mem = false;
+                cache->modified_invalidated = false;
+            }
+        }
+    }
+    if (static_cast<int>(writebackBuffer.size()) > peakWritebackBuffer)
+        peakWritebackBuffer = static_cast<int>(writebackBuffer.size());
+}
+
+void Bus::drainWritebackBuffer(const std::vector<Cache *> &caches)
+{
+    if (drainCycles > 0 && --drainCycles == 0)
+        writebackBuffer.erase(writebackBuffer.begin());
+    if (drainCycles == 0 && !writebackBuffer.empty())
+        drainCycles = writebackLatency(writebackBuffer.front().address, caches);
+}
+
+bool Bus::writebackBufferHolds(uint32_t address, int blockSizeBytes) const
+{
+    uint32_t block = address & ~static_cast<uint32_t>(blockSizeBytes - 1);
+    for (const auto &wb : writebackBuffer)
+    {
+        if (wb.address == block)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------
+size_t Bus::pickWriteback() const
+{
+    if (dram && !l2)
+    {
+        for (size_t i = 0; i < writebackQueue.size(); ++i)
+        {
+            if (dram->isRowHit(writebackQueue[i].address))
+                return i;
+        }
+    }
+    return 0;
+}
+
+bool Bus::isWaiting(const BusTransaction &tx, const std::vector<Cache *> &caches) const
+{
+    // A request is waiting to start if its cache still has no delay set.
+    for (auto c : caches)
+    {
+        if (c->getProcessorId() == tx.sourceProcessorId)
+            return c->isTransactionPending() && c->getPendingAddress() == tx.address &&
+                   c->getPendingCycleCount() == -1;
+    }
+    return false;
+}
+
+void Bus::scheduleRowHitFirst(const std::vector<Cache *> &caches)
+{
+    if (transactions.size() < 2 || !isWaiting(transactions.front(), caches) ||
+        dram->isRowHit(transactions.front().address))
+        return;
+    for (size_t i = 1; i < transactions.size(); ++i)
+    {
+        if (dram->isRowHit(transactions[i].address) && isWaiting(transactions[i], caches))
+        {
+            BusTransaction tx = transactions[i];
+            transactions.erase(transactions.begin() + i);
+            transactions.insert(transactions.begin(), tx);
+            return;
+        }
+    }
+}
+
+void Bus::applyBackInvalidations(const std::vector<Cache *> &caches)
+{
+    // Under --clusters every cluster bus shares the L2, so an L2 eviction
+    // reaches the L1s of all clusters, not just this bus's.
+    const std::vector<Cache *> &all = interconnect ? interconnect->getCaches() : caches;
+    for (uint32_t block : backInvalidations)
+    {
+        for (auto cache : all)
+        {
+            if (cache->backInvalidate(block, l2->getBlockSizeBytes()))
+            {
+                // The L1 data is newer than the L2's; one write covers both.
+                l2->countDirtyBackInvalidation();
+                if (std::find(l2Writebacks.begin(), l2Writebacks.end(), block) == l2Writebacks.end())
+                    l2Writebacks.push_back(block);
+            }
+        }
+    }
+    backInvalidations.clear();
+}
+
+//------------------------------------------------------------------
+// Arbitration.
+void Bus::arbitrate(const std::vector<Cache *> &caches)
+{
+    // Only choose while the head has not been started by the bus.
+    if (transactions.size() < 2 || !isWaiting(transactions.front(), caches))
+        return;
+    int numCores = static_cast<int>(grants.size());
+    uint64_t totalGrants = 0;
+    for (uint64_t g : grants)
+        totalGrants += g;
+
+    // With DRAM and no L2, FR-FCFS still comes first: the policy only
+    // chooses among the requests that hit an open row, if there are any.
+    bool rowHitsOnly = false;
+    if (dram && !l2)
+    {
+        for (size_t i = 0; i < transactions.size() && !rowHitsOnly; ++i)
+            rowHitsOnly = dram->isRowHit(transactions[i].address) && isWaiting(transactions[i], caches);
+    }
+
+    size_t best = 0;
+    double bestScore = 0.0;
+    bool found = false;
+    for (size_t i = 0; i < transactions.size(); ++i)
+    {
+        const BusTransaction &tx = transactions[i];
+        if (i > 0 && !isWaiting(tx, caches))
+            continue;
+        if (rowHitsOnly && !dram->isRowHit(tx.address))
+            continue;
+        int core = tx.sourceProcessorId;
+        double score;
+        switch (arbitration)
+        {
+        case ArbitrationPolicy::RoundRobin:
+            // Distance after the last granted core; nearer is better.
+            score = -static_cast<double>((core - lastGranted - 1 + 2 * numCores) % numCores);
+            break;
+        case ArbitrationPolicy::FixedPriority:
+            score = -static_cast<double>(core);
+            break;
+        case ArbitrationPolicy::AgeWeighted:
+        {
+            // A core with fewer grants than its fair share ages faster.
+            double share = (totalGrants + numCores) / static_cast<double>(numCores * (grants[core] + 1));
+            score = (cycle - tx.issueCycle + 1) * share;
+            break;
+        }
+        default:
+            score = -static_cast<double>(tx.issueCycle);
+            break;
+        }
+        if (!found || score > bestScore)
+        {
+            best = i;
+            bestScore = score;
+            found = true;
+        }
     }
+    if (best != 0)
+    {
+        BusTransaction tx = transactions[best];
+        transactions.erase(transactions.begin() + best);
+        transactions.insert(transactions.begin(), tx);
+    }
+}
+
+void Bus::recordGrant(const BusTransaction &tx)
+{
+    int core = tx.sourceProcessorId;
+    if (core < 0 || core >= static_cast<int>(grants.size()))
+        return;
+    uint64_t wait = cycle - tx.issueCycle;
+    grants[core]++;
+    totalWait[core] += wait;
+    if (wait > maxWait[core])
+        maxWait[core] = wait;
+    lastGranted = core;
 }
 
 void Bus::processUpgrade(
@@ -68,6 +449,14 @@ void Bus::processUpgrade(
 
 void Bus::resolveTransactions(const std::vector<Cache *> &caches)
 {
+    ++cycle;
+
+    if (writebackBufferSize > 0)
+    {
+        drainWritebackBuffer(caches);
+        absorbWritebacks(caches);
+    }
+
     //
     // 0) Finish any outstanding write-back stall
     //
@@ -90,13 +479,39 @@ void Bus::resolveTransactions(const std::vector<Cache *> &caches)
         return;
     }
 
+    //
+    // 0b) A prefetch fill holds the bus until its latency elapses, unless
+    //     demand traffic arrives: the prefetch is then dropped and the bus
+    //     serves the demand in this same cycle.
+    //
+    if (prefetchActive)
+    {
+        if (demandWaiting(caches))
+        {
+            prefetchActive = false;
+            preemptedPrefetches++;
+        }
+        else
+        {
+            if (--prefetchCycles > 0)
+                return;
+            prefetchActive = false;
+            completePrefetch(caches);
+            return;
+        }
+    }
+
     //
     // 1) Process all pending BusUpgr invalidations
     //
     if (!upgradeQueue.empty())
     {
         for (auto &tx : upgradeQueue)
+        {
             processUpgrade(tx, caches);
+            if (interconnect)
+                interconnect->upgradeRemote(tx, cycle);
+        }
         upgradeQueue.clear();
     }
 
@@ -105,29 +520,69 @@ void Bus::resolveTransactions(const std::vector<Cache *> &caches)
     //
     if (!writebackQueue.empty())
     {
-        auto wb = writebackQueue.front();
-        writebackQueue.erase(writebackQueue.begin());
+        // (only reached without a write-back buffer, or when it is full)
+        size_t next = pickWriteback();
+        auto wb = writebackQueue[next];
+        writebackQueue.erase(writebackQueue.begin() + next);
         pendingBusWr        = true;
-        pendingBusWrCycles  = 100;
+        pendingBusWrCycles  = writebackLatency(wb.address, caches);
+        if (interconnect)
+            pendingBusWrCycles += interconnect->writeback(wb.sourceProcessorId, cycle);
         pendingBusWrSourceId = wb.sourceProcessorId;
+        if (writebackBufferSize > 0)
+            blockingWritebacks++;
         return;
     }
 
     //
-    // 3) No normal transactions?  We’re done.
+    // 3) No normal transactions?  Use the idle bus for a prefetch, if any.
     //
     if (transactions.empty())
+    {
+        if (!prefetchQueue.empty())
+            startPrefetch(caches);
         return;
+    }
+
+    // arbitrate() applies FR-FCFS itself before the policy.
+    if (arbitration != ArbitrationPolicy::Fifo)
+        arbitrate(caches);
+    else if (dram && !l2)
+        scheduleRowHitFirst(caches);
 
     //
     // 4) Snooping: inform every other cache of this access
     //
     BusTransaction tx = transactions.front();
+    // The head stays queued while its fill counts down; other clusters see
+    // it once, as it is granted, and not while they still hold the block
+    // for a fill of their own.
+    bool awaitingGrant = false;
+    if (interconnect)
+    {
+        for (auto c : caches)
+        {
+            awaitingGrant |= (c->getProcessorId() == tx.sourceProcessorId && c->getPendingAddress() == tx.address &&
+                              c->isTransactionPending() && c->getPendingCycleCount() == -1);
+        }
+        if (awaitingGrant && interconnect->isHeld(tx, cycle))
+            return;
+    }
+    // Whether a write finds copies to invalidate (the requester reports
+    // atomics that took the block from another cache as contended).
+    bool invalidatesCopies = false;
+    bool isWrite = tx.type != BusTransactionType::BusRd;
     for (auto cache : caches)
     {
         if (cache->getProcessorId() != tx.sourceProcessorId)
+        {
+            invalidatesCopies |= isWrite && cache->getBlockState(tx.address) != MESIState::Invalid;
             cache->handleBusTransaction(tx);
+        }
     }
+    // Other clusters only see what this one cannot serve.
+    uint64_t remoteHolders = awaitingGrant ? interconnect->snoopRemote(tx, caches) : 0;
+    invalidatesCopies |= isWrite && remoteHolders != 0;
 
     //
     // 5) Let the source cache resolve its miss
@@ -162,8 +617,12 @@ void Bus::resolveTransactions(const std::vector<Cache *> &caches)
     if (src->isTransactionPending()) {
         // We haven't set its delay yet
         if (src->getPendingCycleCount() == -1) {
-            int delay = 100;  // default: memory
+            // Write-backs this access's snoop just caused go to the buffer first.
+            if (writebackBufferSize > 0)
+                absorbWritebacks(caches);
+            int delay = -1;  // default: memory
             int extraDelay = 0;
+            bool suppliedByCache = false;
             // If it’s a load, check for cache-to-cache
             if (tx.type == BusTransactionType::BusRd)
             {
@@ -176,7 +635,7 @@ void Bus::resolveTransactions(const std::vector<Cache *> &caches)
                     {
                         supplierId = c->getProcessorId();
                         if(c->is_writing_to_mem) {
-                            extraDelay = 100; // add 100 cycles if the supplier is writing to memory
+                            extraDelay = writebackDuration(); // add the write-back time if the supplier is writing to memory
                             // std::cout << "[Bus] Supplier " << supplierId << " is writing to memory\n";
                         }
                         break;
@@ -184,23 +643,61 @@ void Bus::resolveTransactions(const std::vector<Cache *> &caches)
                 }
                 if (supplierId >= 0)
                 {
+                    suppliedByCache = true;
                     // 2·N cycles, plus 100 if that supplier is itself mid-writeback
                     delay = 2 * n + extraDelay;
                 }
             }
+            // In a cluster, a miss no peer supplies goes to another
+            // cluster's cache or to memory over the interconnect.
+            Cache *remoteSupplier = nullptr;
+            if (interconnect && !suppliedByCache && tx.type == BusTransactionType::BusRd)
+            {
+                remoteSupplier = interconnect->remoteSupplier(tx);
+                if (remoteSupplier)
+                {
+                    suppliedByCache = true;
+                    delay = 2 * (caches[0]->getBlockSizeBytes() / 4) +
+                            (remoteSupplier->is_writing_to_mem ? writebackDuration() : 0);
+                }
+            }
+            if (!suppliedByCache && writebackBufferSize > 0 &&
+                writebackBufferHolds(tx.address, caches[0]->getBlockSizeBytes()))
+            {
+                // The dirty block is still in the write-back buffer, which
+                // supplies it like a cache would (memory is stale).
+                delay = 2 * (caches[0]->getBlockSizeBytes() / 4);
+                writebackBufferHits++;
+            }
+            else if (!suppliedByCache)
+                delay = fetchLatency(tx.address, caches);
             if (tx.type == BusTransactionType::BusRdWITWr)
             {
-                for (auto c : caches)
+                int fetch = delay;
+                for (auto c : interconnect ? interconnect->getCaches() : caches)
                 {
                     if (c->is_writing_to_mem && c != src && c->modified_invalidated)
                     {
-                        delay = 200;
+                        // wait for the previous owner's write-back, then fetch
+                        delay = writebackDuration() + fetch;
                         c->modified_invalidated = false; // reset the flag after processing
                     }
                 }
             }
 
-            src->resolvePendingTransaction(tx.type, tx.address, delay);
+            if (interconnect)
+            {
+                if (suppliedByCache && !remoteSupplier)
+                    interconnect->recordLocalFill(delay);
+                else
+                    delay = interconnect->remoteFill(tx, remoteSupplier ? remoteSupplier->getProcessorId() : -1,
+                                                     delay, cycle, remoteHolders);
+                interconnect->holdBlock(tx, cycle + delay);
+            }
+
+            recordGrant(tx);
+            TRACE_EVENT(Bus, BusGrant, tx.sourceProcessorId, tx.address, delay);
+            src->resolvePendingTransaction(tx.type, tx.address, delay, suppliedByCache || invalidatesCopies);
         }
         // ADDED: If delay has been set to 0, dequeue the transaction
         else if (src->getPendingCycleCount() == 0) {
@@ -219,11 +716,12 @@ void Bus::clearTransactions()
     transactions.clear();
     upgradeQueue.clear();
     writebackQueue.clear();
+    prefetchQueue.clear();
 }
 
-int Bus::updateBusTrafficBytes(const std::vector<Cache *> &caches)
+uint64_t Bus::updateBusTrafficBytes(const std::vector<Cache *> &caches)
 {
-    int total = 0;
+    uint64_t total = 0;
     for (auto c : caches)
         total += c->getDataTrafficBytes();
     busTrafficBytes = total;
@@ -286,6 +784,11 @@ void Bus::printBusinfo() const
         std::cout << "Pending BusWr: " << pendingBusWrCycles << " cycles remaining\n";
 }
 
+size_t Bus::getQueueDepth() const
+{
+    return transactions.size() + upgradeQueue.size() + writebackQueue.size() + prefetchQueue.size();
+}
+
 bool Bus::hasPendingtransaction() const
 {
     return pendingBusWr
@@ -293,3 +796,11 @@ bool Bus::hasPendingtransaction() const
         || !writebackQueue.empty()
         || !transactions.empty();
 }
+
+bool Bus::isIdle() const
+{
+    return !hasPendingtransaction()
+        && !prefetchActive
+        && prefetchQueue.empty()
+        && writebackBuffer.empty();
+}
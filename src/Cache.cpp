@@ -1,8 +1,8 @@
 #include "../header/Cache.hpp"
 #include "../header/DataArray.hpp"
-#include "../header/TagArray.hpp"
 #include "../header/TraceParser.hpp"
 #include "../header/Bus.hpp"
+#include "../header/EventTrace.hpp"
 #include <cmath>
 #include <iostream>
 
@@ -33,24 +33,13 @@ Cache::Cache(int s, int E, int b, int processorId, Bus *busPtr)
       numSets(1 << s),
       blockSizeBytes(1 << b),
       dataArray(E, (1 << b), (1 << s)),
-      tagArray(E, (1 << s)),
+      lines(E, (1 << s)),
       processorId(processorId),
       pendingTransaction(false),
       pendingAddress(0),
       pendingCycleCount(0),
       bus(busPtr)
 {
-    meta.resize(numSets, std::vector<CacheLineMeta>(E));
-    for (int set = 0; set < numSets; ++set)
-    {
-        for (int way = 0; way < E; ++way)
-        {
-            meta[set][way].valid = false;
-            meta[set][way].dirty = false;
-            meta[set][way].state = MESIState::Invalid;
-            meta[set][way].lruCounter = 0;
-        }
-    }
 }
 
 //------------------------------------------------------------------
@@ -70,18 +59,292 @@ int Cache::extractBlockOffset(uint32_t address) const
     return ((address / 4)) % (blockSizeBytes / 4);
 }
 
+//------------------------------------------------------------------
+// Hit-path templates. G is RuntimeGeometry for the generic cache or a
+// FixedGeometry (below) whose constants let the compiler fold the masks and
+// fully unroll the way loops.
+template <class G>
+void Cache::updateLRUIn(const G &g, int setIndex, int way)
+{
+    lines.touch(setIndex, way, g.ways);
+}
+
+template <class G>
+int Cache::findWayIn(const G &g, int setIndex, uint32_t tag) const
+{
+    return lines.findWay(setIndex, tag, g.ways);
+}
+
+template <class G>
+bool Cache::readHitIn(const G &g, uint32_t address)
+{
+    int setIndex = g.set(address);
+    int way = findWayIn(g, setIndex, g.tag(address));
+    if (way < 0)
+        return false;
+    if (lines.meta[setIndex][way].prefetched)
+    {
+        lines.meta[setIndex][way].prefetched = false;
+        usefulPrefetches++;
+        prefetchCandidates.clear();
+        prefetcher->onPrefetchHit(address >> b, prefetchCandidates);
+        issuePrefetches(prefetchCandidates);
+    }
+    updateLRUIn(g, setIndex, way);
+    TRACE_EVENT(Cache, CacheHit, processorId, address, 0);
+    return true;
+}
+
+template <class G>
+bool Cache::hitsLocallyIn(const G &g, uint32_t address, bool isWrite) const
+{
+    if (pendingTransaction)
+        return false;
+    int setIndex = g.set(address);
+    int way = findWayIn(g, setIndex, g.tag(address));
+    if (way < 0 || lines.meta[setIndex][way].prefetched)
+        return false;
+    return !isWrite || lines.meta[setIndex][way].state != MESIState::Shared;
+}
+
+template <class G>
+bool Cache::readIn(const G &g, uint32_t address, int &cycles, Bus *bus)
+{
+    if (pendingTransaction)
+        return false;
+    if (readHitIn(g, address))
+    {
+        cycles = 1;
+        return true;
+    }
+    return readMiss(address, bus);
+}
+
+template <class G>
+bool Cache::writeIn(const G &g, uint32_t address, int &cycles, Bus *bus)
+{
+    if (pendingTransaction)
+        return false;
+    int setIndex = g.set(address);
+    int way = findWayIn(g, setIndex, g.tag(address));
+    if (way < 0)
+        return writeMiss(address, bus);
+
+    // Shared->Modified upgrade
+    if (lines.meta[setIndex][way].state == MESIState::Shared && bus)
+    {
+        BusTransaction tx;
+        tx.type = BusTransactionType::BusUpgr;
+        tx.address = address;
+        tx.sourceProcessorId = processorId;
+        bus->addTransaction(tx);
+        busInvalidations++;
+    }
+
+    if (lines.meta[setIndex][way].prefetched)
+    {
+        lines.meta[setIndex][way].prefetched = false;
+        usefulPrefetches++;
+        prefetchCandidates.clear();
+        prefetcher->onPrefetchHit(address >> b, prefetchCandidates);
+        issuePrefetches(prefetchCandidates);
+    }
+    lines.meta[setIndex][way].dirty = true;
+    lines.meta[setIndex][way].state = MESIState::Modified;
+    updateLRUIn(g, setIndex, way);
+    TRACE_EVENT(Cache, CacheHit, processorId, address, 1);
+    cycles = 1;
+    return true;
+}
+
 //------------------------------------------------------------------
 // LRU Update Function.
 void Cache::updateLRU(int setIndex, int way)
 {
-    meta[setIndex][way].lruCounter = 0;
-    for (int i = 0; i < E; ++i)
+    updateLRUIn(runtimeGeometry(), setIndex, way);
+}
+
+//------------------------------------------------------------------
+// Lookup and install helpers.
+int Cache::findWay(int setIndex, uint32_t tag) const
+{
+    return findWayIn(runtimeGeometry(), setIndex, tag);
+}
+
+int Cache::installBlock(int setIndex, uint32_t tag, MESIState state)
+{
+    int victim = lines.pickVictim(setIndex, E);
+
+    // evict if needed
+    if (lines.meta[setIndex][victim].valid && !victimCache.empty())
+    {
+        // The victim cache keeps the line, so nothing is written back yet.
+        uint32_t victimAddr = lines.blockAddress(setIndex, victim, s, b);
+        fillVictimCache(victimAddr >> b, lines.meta[setIndex][victim].state);
+    }
+    else if (lines.meta[setIndex][victim].valid && lines.meta[setIndex][victim].dirty)
+    {
+        // Writeback the block to memory
+        uint32_t victimAddr = lines.blockAddress(setIndex, victim, s, b);
+        bus->addTransaction({BusTransactionType::BusWr,
+                             victimAddr,
+                             processorId});
+        is_writing_to_mem = true;
+        writebacks++;
+    }
+    MESIState oldState = lines.meta[setIndex][victim].state;
+    if(oldState != MESIState::Invalid) {
+        cacheEvictions++;
+        TRACE_EVENT(Cache, CacheEvict, processorId,
+                    lines.blockAddress(setIndex, victim, s, b), oldState);
+    }
+    if (lines.meta[setIndex][victim].valid && lines.meta[setIndex][victim].prefetched)
+    {
+        unusedPrefetches++;
+    }
+    // install new block
+    lines.tagArray.tags[setIndex][victim] = tag;
+    lines.meta[setIndex][victim].valid = true;
+    lines.meta[setIndex][victim].dirty = (state == MESIState::Modified);
+    lines.meta[setIndex][victim].state = state;
+    lines.meta[setIndex][victim].prefetched = false;
+    updateLRU(setIndex, victim);
+    return victim;
+}
+
+//------------------------------------------------------------------
+// Victim cache.
+void Cache::setVictimCacheSize(int entries)
+{
+    victimCache.assign(entries, VictimLine{false, 0, MESIState::Invalid, 0});
+}
+
+int Cache::findVictim(uint32_t block) const
+{
+    for (size_t i = 0; i < victimCache.size(); ++i)
+    {
+        if (victimCache[i].valid && victimCache[i].block == block)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void Cache::fillVictimCache(uint32_t block, MESIState state)
+{
+    size_t slot = 0;
+    for (size_t i = 0; i < victimCache.size(); ++i)
+    {
+        if (!victimCache[i].valid)
+        {
+            slot = i;
+            break;
+        }
+        if (victimCache[i].lruCounter > victimCache[slot].lruCounter)
+            slot = i;
+    }
+    VictimLine &line = victimCache[slot];
+    if (line.valid && line.state == MESIState::Modified)
+    {
+        bus->addTransaction({BusTransactionType::BusWr, line.block << b, processorId});
+        is_writing_to_mem = true;
+        writebacks++;
+    }
+    for (auto &other : victimCache)
+    {
+        if (other.valid)
+            other.lruCounter++;
+    }
+    line.valid = true;
+    line.block = block;
+    line.state = state;
+    line.lruCounter = 0;
+}
+
+bool Cache::swapInFromVictimCache(uint32_t address, BusTransactionType type)
+{
+    victimProbes++;
+    int i = findVictim(address >> b);
+    if (i < 0)
+        return false;
+    MESIState state = victimCache[i].state;
+    victimCache[i].valid = false;
+    // The L1 line this displaces takes the freed victim cache slot.
+    installBlock(extractSetIndex(address), extractTag(address), state);
+    victimHits++;
+    victimCyclesSaved += 100 - victimHitLatency;
+
+    // The access is re-executed (and hits, or upgrades a Shared line) once
+    // the swap latency has elapsed.
+    pendingTransaction = true;
+    fillShared = false;
+    fillSwapped = true;
+    pendingAddress = address;
+    pendingType = type;
+    pendingCycleCount = victimHitLatency;
+    cacheMisses++;
+    return true;
+}
+
+void Cache::snoopVictimCache(const BusTransaction &tx)
+{
+    int i = findVictim(tx.address >> b);
+    if (i < 0)
+        return;
+    VictimLine &line = victimCache[i];
+    if (line.state == MESIState::Modified)
+    {
+        bus->addTransaction({BusTransactionType::BusWr, tx.address, processorId});
+        is_writing_to_mem = true;
+        if (tx.type != BusTransactionType::BusRd)
+            modified_invalidated = true;
+        writebacks++;
+        dataTrafficBytes += blockSizeBytes;
+    }
+    if (tx.type == BusTransactionType::BusRd)
+        line.state = MESIState::Shared;
+    else
+        line.valid = false;
+}
+
+//------------------------------------------------------------------
+// Prefetch support.
+void Cache::issuePrefetches(const std::vector<uint32_t> &blocks)
+{
+    for (uint32_t block : blocks)
+    {
+        uint32_t address = block << b;
+        if (findWay(extractSetIndex(address), extractTag(address)) >= 0)
+            continue;
+        if (pendingTransaction && (pendingAddress >> b) == block)
+            continue;
+        if (bus->addPrefetch({BusTransactionType::BusRd, address, processorId}))
+            prefetchesIssued++;
+    }
+}
+
+void Cache::installPrefetch(uint32_t address, bool shared)
+{
+    int setIndex = extractSetIndex(address);
+    uint32_t tag = extractTag(address);
+    if (findWay(setIndex, tag) >= 0 || findVictim(address >> b) >= 0)
+        return;
+    // The demand miss for this block is already queued: the prefetch lost
+    // the race. A queued read is still served by the fill that just arrived;
+    // a write must wait for its own transaction to invalidate other copies.
+    if (pendingTransaction && (pendingAddress >> b) == (address >> b))
     {
-        if (i != way && meta[setIndex][i].valid)
+        latePrefetches++;
+        if (pendingCycleCount == -1 && pendingType == BusTransactionType::BusRd)
         {
-            meta[setIndex][i].lruCounter++;
+            resolvePendingTransaction(pendingType, pendingAddress, 1, shared);
+            prefetchTrafficBytes += blockSizeBytes;
         }
+        return;
     }
+    int way = installBlock(setIndex, tag, shared ? MESIState::Shared : MESIState::Exclusive);
+    lines.meta[setIndex][way].prefetched = true;
+    dataTrafficBytes += blockSizeBytes;
+    prefetchTrafficBytes += blockSizeBytes;
 }
 
 //------------------------------------------------------------------
@@ -96,23 +359,19 @@ bool Cache::read(uint32_t address, int &cycles)
 // Bus-aware read.
 bool Cache::read(uint32_t address, int &cycles, Bus *bus)
 {
-    if (pendingTransaction)
-        return false;
-    int setIndex = extractSetIndex(address);
-    uint32_t tag = extractTag(address);
+    return readIn(runtimeGeometry(), address, cycles, bus);
+}
 
-    for (int way = 0; way < E; ++way)
-    {
-        if (meta[setIndex][way].valid && tagArray.tags[setIndex][way] == tag)
-        {
-            updateLRU(setIndex, way);
-            cycles = 1;
-            return true;
-        }
-    }
+bool Cache::readMiss(uint32_t address, Bus *bus)
+{
+    TRACE_EVENT(Cache, CacheMiss, processorId, address, 0);
+    if (!victimCache.empty() && swapInFromVictimCache(address, BusTransactionType::BusRd))
+        return false;
     // Miss: issue a BusRd transaction.
     if (bus)
     {
+        if (prefetcher && bus->cancelPrefetch(address & ~((1u << b) - 1), processorId))
+            latePrefetches++;
         BusTransaction tx;
         tx.type = BusTransactionType::BusRd;
         tx.address = address;
@@ -120,10 +379,18 @@ bool Cache::read(uint32_t address, int &cycles, Bus *bus)
         bus->addTransaction(tx);
     }
     pendingTransaction = true;
+    fillShared = false;
+    fillSwapped = false;
     pendingAddress = address;
     pendingType = BusTransactionType::BusRd;
     pendingCycleCount = -1;
     cacheMisses++;
+    if (prefetcher && bus)
+    {
+        prefetchCandidates.clear();
+        prefetcher->onMiss(address >> b, prefetchCandidates);
+        issuePrefetches(prefetchCandidates);
+    }
     return false;
 }
 
@@ -138,43 +405,29 @@ bool Cache::write(uint32_t address, int &cycles)
 
 // Bus-aware write.
 bool Cache::write(uint32_t address, int &cycles, Bus *bus)
+{
+    return writeIn(runtimeGeometry(), address, cycles, bus);
+}
+
+bool Cache::atomic(uint32_t address, int &cycles, Bus *bus)
 {
     if (pendingTransaction)
         return false;
-    int setIndex = extractSetIndex(address);
-    uint32_t tag = extractTag(address);
+    if (bus && getBlockState(address) == MESIState::Shared)
+        return writeMiss(address, bus);
+    return write(address, cycles, bus);
+}
 
-    for (int way = 0; way < E; ++way)
-    {
-        if (meta[setIndex][way].valid && tagArray.tags[setIndex][way] == tag)
-        {
-            // Shared->Modified upgrade
-            if (meta[setIndex][way].state == MESIState::Shared && bus)
-            {
-                BusTransaction tx;
-                tx.type = BusTransactionType::BusUpgr;
-                tx.address = address;
-                tx.sourceProcessorId = processorId;
-                bus->addTransaction(tx);
-                busInvalidations++;
-            }
-            
-            meta[setIndex][way].dirty = true;
-            MESIState oldState = meta[setIndex][way].state;
-            meta[setIndex][way].state = MESIState::Modified;
-            // std::cout << "[Cache " << processorId << "] WRITE hit at set " << setIndex
-            //           << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
-            //           << ", " << mesiStateToString(oldState)
-            //           << " -> " << mesiStateToString(meta[setIndex][way].state)
-            //           << std::endl;
-            updateLRU(setIndex, way);
-            cycles = 1;
-            return true;
-        }
-    }
+bool Cache::writeMiss(uint32_t address, Bus *bus)
+{
+    TRACE_EVENT(Cache, CacheMiss, processorId, address, 1);
+    if (!victimCache.empty() && swapInFromVictimCache(address, BusTransactionType::BusRdWITWr))
+        return false;
     // Write miss: issue a BusRdWITWr transaction.
     if (bus)
     {
+        if (prefetcher && bus->cancelPrefetch(address & ~((1u << b) - 1), processorId))
+            latePrefetches++;
         BusTransaction tx;
         tx.type = BusTransactionType::BusRdWITWr;
         tx.address = address;
@@ -183,22 +436,31 @@ bool Cache::write(uint32_t address, int &cycles, Bus *bus)
     }
     busInvalidations++;
     pendingTransaction = true;
+    fillShared = false;
+    fillSwapped = false;
     pendingAddress = address;
     pendingType = BusTransactionType::BusRdWITWr;
     pendingCycleCount = -1;
     cacheMisses++;
+    if (prefetcher && bus)
+    {
+        prefetchCandidates.clear();
+        prefetcher->onMiss(address >> b, prefetchCandidates);
+        issuePrefetches(prefetchCandidates);
+    }
     return false;
 }
 
 //------------------------------------------------------------------
 // resolvePendingTransaction: Called by the Bus to set the delay and install the block.
-void Cache::resolvePendingTransaction(BusTransactionType type, uint32_t address, int delay)
+void Cache::resolvePendingTransaction(BusTransactionType type, uint32_t address, int delay, bool shared)
 {
     if (!pendingTransaction || pendingAddress != address)
         return;
     if (pendingCycleCount == -1)
     {
         pendingCycleCount = delay; // set delay
+        fillShared = shared;
 
         // update traffic and eviction counters
         if (delay != 100)
@@ -214,59 +476,39 @@ void Cache::resolvePendingTransaction(BusTransactionType type, uint32_t address,
 
         int setIndex = extractSetIndex(address);
         uint32_t tag = extractTag(address);
-        int victim = 0;
-        // find victim via LRU or empty
-        for (int way = 0; way < E; ++way)
+        MESIState newState;
+        if (type == BusTransactionType::BusRd)
         {
-            if (!meta[setIndex][way].valid)
-            {
-                victim = way;
-                break;
-            }
-            if (meta[setIndex][way].lruCounter > meta[setIndex][victim].lruCounter)
-            {
-                victim = way;
-            }
+            newState = shared ? MESIState::Shared : MESIState::Exclusive;
         }
-        
-        // evict if needed
-        if (meta[setIndex][victim].valid && meta[setIndex][victim].dirty)
+        else
         {
-            // Writeback the block to memory
-            // compute the victim block’s starting address
-            uint32_t victimTag = tagArray.tags[setIndex][victim];
-            uint32_t victimAddr = (victimTag << (s + b)) | (setIndex << b);
-            bus->addTransaction({BusTransactionType::BusWr,
-                                 victimAddr,
-                                 processorId});
-            is_writing_to_mem = true;
-            writebacks++;
+            newState = MESIState::Modified;
         }
-        MESIState oldState = meta[setIndex][victim].state;
-        if(oldState != MESIState::Invalid) {
-            cacheEvictions++;
-        }
-        // install new block
-        tagArray.tags[setIndex][victim] = tag;
-        meta[setIndex][victim].valid = true;
-        if (type == BusTransactionType::BusRd)
+        // A prefetch may have installed the block while this miss was queued.
+        int victim = findWay(setIndex, tag);
+        if (victim >= 0)
         {
-            meta[setIndex][victim].dirty = false;
-            meta[setIndex][victim].state = (delay == 100)
-                                               ? MESIState::Exclusive
-                                               : MESIState::Shared;
+            if (lines.meta[setIndex][victim].prefetched)
+            {
+                lines.meta[setIndex][victim].prefetched = false;
+                latePrefetches++;
+            }
+            lines.meta[setIndex][victim].state = newState;
+            lines.meta[setIndex][victim].dirty = (newState == MESIState::Modified);
+            updateLRU(setIndex, victim);
         }
         else
         {
-            meta[setIndex][victim].dirty = true;
-            meta[setIndex][victim].state = MESIState::Modified;
+            victim = installBlock(setIndex, tag, newState);
         }
-        updateLRU(setIndex, victim);
+        TRACE_EVENT(Cache, CacheFill, processorId, address,
+                    static_cast<uint32_t>(newState) | (static_cast<uint32_t>(delay) << 8));
 
         // std::cout << "[Cache " << processorId << "] Installed block at set " << setIndex
         //           << ", way " << victim << ", tag 0x" << std::hex << tag << std::dec
         //           << ", " << mesiStateToString(oldState)
-        //           << " -> " << mesiStateToString(meta[setIndex][victim].state)
+        //           << " -> " << mesiStateToString(lines.meta[setIndex][victim].state)
         //           << "\n";
     }
 }
@@ -287,6 +529,43 @@ void Cache::decrementPendingCycle()
     }
 }
 
+//------------------------------------------------------------------
+// Utility: Checks whether an access can complete as a plain L1 hit.
+bool Cache::hitsLocally(uint32_t address, bool isWrite) const
+{
+    return hitsLocallyIn(runtimeGeometry(), address, isWrite);
+}
+
+//------------------------------------------------------------------
+bool Cache::readHit(uint32_t address)
+{
+    return readHitIn(runtimeGeometry(), address);
+}
+
+bool Cache::chargeHits(uint32_t address, bool anyWrite)
+{
+    if (!readHit(address))
+        return false;
+    if (anyWrite)
+    {
+        int setIndex = extractSetIndex(address);
+        int way = findWay(setIndex, extractTag(address));
+        lines.meta[setIndex][way].dirty = true;
+        lines.meta[setIndex][way].state = MESIState::Modified;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+MESIState Cache::getBlockState(uint32_t address) const
+{
+    int way = findWay(extractSetIndex(address), extractTag(address));
+    if (way >= 0)
+        return lines.meta[extractSetIndex(address)][way].state;
+    int line = findVictim(address >> b);
+    return (line >= 0) ? victimCache[line].state : MESIState::Invalid;
+}
+
 //------------------------------------------------------------------
 // Utility: Checks if this cache holds the block for a given address.
 bool Cache::hasBlock(uint32_t address) const
@@ -295,20 +574,22 @@ bool Cache::hasBlock(uint32_t address) const
     uint32_t tag = extractTag(address);
     for (int way = 0; way < E; ++way)
     {
-        if (meta[setIndex][way].valid && tagArray.tags[setIndex][way] == tag)
+        if (lines.meta[setIndex][way].valid && lines.tagArray.tags[setIndex][way] == tag)
         {
-            if (meta[setIndex][way].state == MESIState::Shared ||
-                meta[setIndex][way].state == MESIState::Exclusive)
+            if (lines.meta[setIndex][way].state == MESIState::Shared ||
+                lines.meta[setIndex][way].state == MESIState::Exclusive)
             {
                 // std::cout << "[Cache " << processorId << "] hasBlock at set " << setIndex
                 //           << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
-                //           << ", " << mesiStateToString(meta[setIndex][way].state) << std::endl;
+                //           << ", " << mesiStateToString(lines.meta[setIndex][way].state) << std::endl;
 
                 return true;
             }
         }
     }
-    return false;
+    int line = findVictim(address >> b);
+    return line >= 0 && (victimCache[line].state == MESIState::Shared ||
+                         victimCache[line].state == MESIState::Exclusive);
 }
 
 //------------------------------------------------------------------
@@ -317,13 +598,15 @@ void Cache::handleBusTransaction(const BusTransaction &tx)
 {
     if (processorId == tx.sourceProcessorId)
         return;
+    if (!victimCache.empty())
+        snoopVictimCache(tx);
     int setIndex = extractSetIndex(tx.address);
     uint32_t tag = extractTag(tx.address);
     for (int way = 0; way < E; ++way)
     {
-        if (meta[setIndex][way].valid && tagArray.tags[setIndex][way] == tag)
+        if (lines.meta[setIndex][way].valid && lines.tagArray.tags[setIndex][way] == tag)
         {
-            MESIState oldState = meta[setIndex][way].state;
+            MESIState oldState = lines.meta[setIndex][way].state;
             switch (tx.type)
             {
             case BusTransactionType::BusRd:
@@ -340,8 +623,9 @@ void Cache::handleBusTransaction(const BusTransaction &tx)
                         dataTrafficBytes += blockSizeBytes;
                         // busInvalidations++;
                     }
-                    meta[setIndex][way].state = MESIState::Shared;
-                    meta[setIndex][way].dirty = false;
+                    lines.meta[setIndex][way].state = MESIState::Shared;
+                    lines.meta[setIndex][way].dirty = false;
+                    TRACE_EVENT(Snoop, SnoopDowngrade, processorId, tx.address, oldState);
                     // std::cout << "[Cache " << processorId << "] Snooped BusRd at set " << setIndex
                     //           << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
                     //           << ", " << mesiStateToString(oldState)
@@ -360,9 +644,15 @@ void Cache::handleBusTransaction(const BusTransaction &tx)
                     dataTrafficBytes += blockSizeBytes;
                 }
                 
-                meta[setIndex][way].state = MESIState::Invalid;
-                meta[setIndex][way].valid = false;
-                meta[setIndex][way].dirty = false;
+                if (lines.meta[setIndex][way].prefetched)
+                {
+                    lines.meta[setIndex][way].prefetched = false;
+                    unusedPrefetches++;
+                }
+                lines.meta[setIndex][way].state = MESIState::Invalid;
+                lines.meta[setIndex][way].valid = false;
+                lines.meta[setIndex][way].dirty = false;
+                TRACE_EVENT(Snoop, SnoopInvalidate, processorId, tx.address, oldState);
                 // std::cout << "[Cache " << processorId << "] Snooped BusRdX/WITWr at set "
                 //           << setIndex << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
                 //           << ", " << mesiStateToString(oldState)
@@ -380,9 +670,15 @@ void Cache::handleBusTransaction(const BusTransaction &tx)
                 dataTrafficBytes += blockSizeBytes;
             }
                 // busInvalidations++;
-                meta[setIndex][way].state = MESIState::Invalid;
-                meta[setIndex][way].valid = false;
-                meta[setIndex][way].dirty = false;
+                if (lines.meta[setIndex][way].prefetched)
+                {
+                    lines.meta[setIndex][way].prefetched = false;
+                    unusedPrefetches++;
+                }
+                lines.meta[setIndex][way].state = MESIState::Invalid;
+                lines.meta[setIndex][way].valid = false;
+                lines.meta[setIndex][way].dirty = false;
+                TRACE_EVENT(Snoop, SnoopInvalidate, processorId, tx.address, oldState);
                 // std::cout << "[Cache " << processorId << "] Snooped BusUpgr at set " << setIndex
                 //           << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
                 //           << ", " << mesiStateToString(oldState)
@@ -399,16 +695,25 @@ void Cache::invalidateShared(uint32_t address)
 {
     int setIndex = extractSetIndex(address);
     uint32_t tag = extractTag(address);
+    int line = findVictim(address >> b);
+    if (line >= 0 && victimCache[line].state == MESIState::Shared)
+        victimCache[line].valid = false;
     for (int way = 0; way < E; ++way)
     {
-        if (meta[setIndex][way].valid && tagArray.tags[setIndex][way] == tag)
+        if (lines.meta[setIndex][way].valid && lines.tagArray.tags[setIndex][way] == tag)
         {
-            if (meta[setIndex][way].state == MESIState::Shared)
+            if (lines.meta[setIndex][way].state == MESIState::Shared)
             {
-                MESIState oldState = meta[setIndex][way].state;
-                meta[setIndex][way].state = MESIState::Invalid;
-                meta[setIndex][way].valid = false;
-                meta[setIndex][way].dirty = false;
+                MESIState oldState = lines.meta[setIndex][way].state;
+                if (lines.meta[setIndex][way].prefetched)
+                {
+                    lines.meta[setIndex][way].prefetched = false;
+                    unusedPrefetches++;
+                }
+                lines.meta[setIndex][way].state = MESIState::Invalid;
+                lines.meta[setIndex][way].valid = false;
+                lines.meta[setIndex][way].dirty = false;
+                TRACE_EVENT(Snoop, SnoopInvalidate, processorId, address, oldState);
                 // busInvalidations++;
                 // std::cout << "[Cache " << processorId << "] invalidateShared at set " << setIndex
                 //           << ", way " << way << ", tag 0x" << std::hex << tag << std::dec
@@ -438,11 +743,11 @@ void Cache::printCacheInfo() const
     //     std::cout << "    Set " << set << ": ";
     //     for (int way = 0; way < E; ++way)
     //     {
-    //         if (meta[set][way].valid)
+    //         if (lines.meta[set][way].valid)
     //         {
     //             std::cout << "[Way " << way << ": Tag 0x" << std::hex
-    //                       << tagArray.tags[set][way] << std::dec
-    //                       << ", State: " << mesiStateToString(meta[set][way].state) << "] ";
+    //                       << lines.tagArray.tags[set][way] << std::dec
+    //                       << ", State: " << mesiStateToString(lines.meta[set][way].state) << "] ";
     //         }
     //     }
     //     std::cout << "\n";
@@ -455,4 +760,83 @@ void Cache::printCacheInfo() const
     std::cout << "is_writing_to_mem: " << (is_writing_to_mem ? "Yes" : "No") << "\n";
     std::cout << "----------------------------------------\n" << std :: endl;
 
-}
\ No newline at end of file
+}
+
+//------------------------------------------------------------------
+bool Cache::backInvalidate(uint32_t address, int bytes)
+{
+    bool dirty = false;
+    for (int offset = 0; offset < bytes; offset += blockSizeBytes)
+    {
+        int setIndex = extractSetIndex(address + offset);
+        int way = findWay(setIndex, extractTag(address + offset));
+        if (way < 0)
+            continue;
+        if (lines.meta[setIndex][way].state == MESIState::Modified)
+            dirty = true;
+        if (lines.meta[setIndex][way].prefetched)
+            unusedPrefetches++;
+        lines.meta[setIndex][way].state = MESIState::Invalid;
+        lines.meta[setIndex][way].valid = false;
+        lines.meta[setIndex][way].dirty = false;
+        lines.meta[setIndex][way].prefetched = false;
+        cacheEvictions++;
+    }
+    for (auto &line : victimCache)
+    {
+        if (line.valid && (line.block << b) - address < static_cast<uint32_t>(bytes))
+        {
+            if (line.state == MESIState::Modified)
+                dirty = true;
+            line.valid = false;
+        }
+    }
+    return dirty;
+}
+
+//------------------------------------------------------------------
+// Compile-time geometries.
+template <int S, int Ways, int B>
+struct FixedGeometry
+{
+    static const int ways = Ways;
+    uint32_t tag(uint32_t address) const { return address >> (S + B); }
+    int set(uint32_t address) const { return (address >> B) & ((1 << S) - 1); }
+};
+
+// A Cache whose hit paths are instantiated for one geometry. Everything
+// else (misses, snooping, statistics) is the shared runtime code.
+template <int S, int Ways, int B>
+class FixedGeometryCache : public Cache
+{
+public:
+    FixedGeometryCache(int processorId, Bus *busPtr)
+        : Cache(S, Ways, B, processorId, busPtr) {}
+
+    using Cache::read;
+    using Cache::write;
+    bool read(uint32_t address, int &cycles, Bus *bus) override { return readIn(geometry, address, cycles, bus); }
+    bool write(uint32_t address, int &cycles, Bus *bus) override { return writeIn(geometry, address, cycles, bus); }
+    bool readHit(uint32_t address) override { return readHitIn(geometry, address); }
+    bool hitsLocally(uint32_t address, bool isWrite) const override { return hitsLocallyIn(geometry, address, isWrite); }
+    bool isSpecialized() const override { return true; }
+
+private:
+    FixedGeometry<S, Ways, B> geometry;
+};
+
+Cache *Cache::create(int s, int E, int b, int processorId, Bus *busPtr, bool generic)
+{
+    if (!generic)
+    {
+        if (s == 6 && E == 2 && b == 5)
+            return new FixedGeometryCache<6, 2, 5>(processorId, busPtr);
+        if (s == 7 && E == 2 && b == 5)
+            return new FixedGeometryCache<7, 2, 5>(processorId, busPtr);
+        if (s == 6 && E == 2 && b == 6)
+            return new FixedGeometryCache<6, 2, 6>(processorId, busPtr);
+        if (s == 6 && E == 4 && b == 5)
+            return new FixedGeometryCache<6, 4, 5>(processorId, busPtr);
+    }
+    return new Cache(s, E, b, processorId, busPtr);
+}
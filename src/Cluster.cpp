@@ -0,0 +1,319 @@
+#include "Cluster.hpp"
+#include "Cache.hpp"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+bool parseClusterSpec(const std::string &spec, ClusterConfig &config)
+{
+    std::string count = spec.substr(0, spec.find(':'));
+    try
+    {
+        config.clusters = std::stoi(count);
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Invalid cluster count '" << count << "'" << std::endl;
+        return false;
+    }
+    if (config.clusters < 1)
+    {
+        std::cerr << "Cluster count must be at least 1" << std::endl;
+        return false;
+    }
+
+    if (spec.find(':') == std::string::npos)
+        return true;
+
+    std::istringstream knobs(spec.substr(spec.find(':') + 1));
+    std::string knob;
+    while (std::getline(knobs, knob, ','))
+    {
+        size_t eq = knob.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Malformed cluster knob '" << knob << "' (expected key=value)" << std::endl;
+            return false;
+        }
+        std::string key = knob.substr(0, eq);
+        int value;
+        try
+        {
+            value = std::stoi(knob.substr(eq + 1), nullptr, 0);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for cluster knob '" << key << "': " << knob.substr(eq + 1) << std::endl;
+            return false;
+        }
+        if (value < 0 || (value == 0 && key != "latency" && key != "header"))
+        {
+            std::cerr << "Cluster knob '" << key << "' out of range: " << value << std::endl;
+            return false;
+        }
+        if (key == "latency")
+            config.linkLatency = value;
+        else if (key == "bandwidth")
+            config.bytesPerCycle = value;
+        else if (key == "header")
+            config.headerBytes = value;
+        else
+        {
+            std::cerr << "Unknown cluster knob '" << key << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+ClusterInterconnect::ClusterInterconnect(const ClusterConfig &config, int numCores)
+    : config(config),
+      coresPerCluster(std::max(1, numCores / config.clusters)),
+      upBookings(config.clusters),
+      downBookings(config.clusters)
+{
+}
+
+void ClusterInterconnect::setCaches(const std::vector<Cache *> &all)
+{
+    caches = all;
+    blockSizeBytes = all.empty() ? 0 : all[0]->getBlockSizeBytes();
+}
+
+uint64_t ClusterInterconnect::reserve(std::vector<Booking> &port, uint64_t when, int cycles)
+{
+    size_t expired = 0;
+    while (expired < port.size() && port[expired].end <= now)
+        expired++;
+    port.erase(port.begin(), port.begin() + expired);
+
+    uint64_t start = when;
+    size_t i = 0;
+    for (; i < port.size(); ++i)
+    {
+        if (start + cycles <= port[i].start)
+            break;
+        start = std::max(start, port[i].end);
+    }
+    port.insert(port.begin() + i, Booking{start, start + cycles});
+    contentionCycles += start - when;
+    return start;
+}
+
+uint64_t ClusterInterconnect::send(int from, int to, uint64_t when, int bytes)
+{
+    messages++;
+    remoteBytes += bytes;
+    int cycles = (bytes + config.bytesPerCycle - 1) / config.bytesPerCycle;
+    uint64_t t = when;
+    if (from >= 0)
+        t = reserve(upBookings[from], t, cycles);
+    t += config.linkLatency;
+    if (to >= 0)
+        t = reserve(downBookings[to], t, cycles);
+    return t + cycles;
+}
+
+//------------------------------------------------------------------
+uint64_t ClusterInterconnect::snoopRemote(const BusTransaction &tx, const std::vector<Cache *> &local)
+{
+    // Any valid peer copy supplies a BusRd, and then no other cluster can
+    // hold the block Exclusive or Modified.
+    if (tx.type == BusTransactionType::BusRd)
+    {
+        for (Cache *c : local)
+        {
+            if (c->getProcessorId() != tx.sourceProcessorId && c->hasBlock(tx.address))
+                return 0;
+        }
+    }
+    int home = clusterOf(tx.sourceProcessorId);
+    uint64_t holders = 0;
+    for (Cache *c : caches)
+    {
+        int cluster = clusterOf(c->getProcessorId());
+        if (cluster == home)
+            continue;
+        if (c->getBlockState(tx.address) != MESIState::Invalid)
+            holders |= 1ULL << cluster;
+        c->handleBusTransaction(tx);
+    }
+    return holders;
+}
+
+Cache *ClusterInterconnect::remoteSupplier(const BusTransaction &tx) const
+{
+    int home = clusterOf(tx.sourceProcessorId);
+    for (Cache *c : caches)
+    {
+        if (clusterOf(c->getProcessorId()) != home && c->hasBlock(tx.address))
+            return c;
+    }
+    return nullptr;
+}
+
+void ClusterInterconnect::upgradeRemote(const BusTransaction &tx, uint64_t cycle)
+{
+    int home = clusterOf(tx.sourceProcessorId);
+    uint64_t holders = 0;
+    for (Cache *c : caches)
+    {
+        int cluster = clusterOf(c->getProcessorId());
+        if (cluster == home || c->getBlockState(tx.address) == MESIState::Invalid)
+            continue;
+        holders |= 1ULL << cluster;
+        c->invalidateShared(tx.address);
+    }
+    if (holders == 0)
+        return;
+    // Like an upgrade on the bus, the writer does not wait for the acks.
+    now = cycle;
+    remoteUpgrades++;
+    for (int cluster = 0; cluster < config.clusters; ++cluster)
+    {
+        if (holders & (1ULL << cluster))
+            send(home, cluster, now, config.headerBytes);
+    }
+}
+
+int ClusterInterconnect::remoteFill(const BusTransaction &tx, int supplier, int serviceCycles, uint64_t cycle,
+                                    uint64_t holders)
+{
+    now = cycle;
+    int home = clusterOf(tx.sourceProcessorId);
+    int from = (supplier >= 0) ? clusterOf(supplier) : -1;
+    if (tx.type == BusTransactionType::BusRd)
+        holders = 0; // Remote copies stay valid.
+    uint64_t request = send(home, from, now, config.headerBytes);
+    uint64_t done = send(from, home, request + serviceCycles, config.headerBytes + blockSizeBytes);
+    for (int cluster = 0; cluster < config.clusters; ++cluster)
+    {
+        if (cluster == from || !(holders & (1ULL << cluster)))
+            continue;
+        uint64_t arrive = send(home, cluster, now, config.headerBytes);
+        done = std::max(done, send(cluster, home, arrive, config.headerBytes));
+    }
+
+    int delay = static_cast<int>(std::max<uint64_t>(done - now, 1));
+    remoteFills++;
+    remoteFillLatency += delay;
+    if (supplier >= 0)
+        remoteCacheFills++;
+    return delay;
+}
+
+int ClusterInterconnect::writeback(int core, uint64_t cycle)
+{
+    now = cycle;
+    remoteWritebacks++;
+    return static_cast<int>(send(clusterOf(core), -1, now, config.headerBytes + blockSizeBytes) - now);
+}
+
+void ClusterInterconnect::recordLocalFill(int delay)
+{
+    localFills++;
+    localFillLatency += delay;
+    localBytes += blockSizeBytes;
+}
+
+void ClusterInterconnect::holdBlock(const BusTransaction &tx, uint64_t until)
+{
+    holds[tx.address / blockSizeBytes] = Hold{clusterOf(tx.sourceProcessorId), until};
+}
+
+bool ClusterInterconnect::isHeld(const BusTransaction &tx, uint64_t cycle)
+{
+    auto it = holds.find(tx.address / blockSizeBytes);
+    if (it == holds.end())
+        return false;
+    if (cycle > it->second.until)
+    {
+        holds.erase(it);
+        return false;
+    }
+    return it->second.cluster != clusterOf(tx.sourceProcessorId);
+}
+
+//------------------------------------------------------------------
+ClusteredBus::ClusteredBus(const ClusterConfig &config, int numCores)
+    : interconnect(config, numCores)
+{
+    for (int i = 0; i < config.clusters; ++i)
+    {
+        clusters.emplace_back(new Bus());
+        clusters.back()->setInterconnect(&interconnect);
+    }
+    clusterCaches.resize(config.clusters);
+}
+
+void ClusteredBus::setL2(L2Cache *cache)
+{
+    for (auto &cluster : clusters)
+        cluster->setL2(cache);
+}
+
+void ClusteredBus::setDram(Dram *memory)
+{
+    for (auto &cluster : clusters)
+        cluster->setDram(memory);
+}
+
+void ClusteredBus::setArbitration(ArbitrationPolicy policy, int numCores)
+{
+    Bus::setArbitration(policy, numCores);
+    for (auto &cluster : clusters)
+        cluster->setArbitration(policy, numCores);
+}
+
+void ClusteredBus::addTransaction(const BusTransaction &transaction)
+{
+    getClusterBus(transaction.sourceProcessorId)->addTransaction(transaction);
+}
+
+void ClusteredBus::resolveTransactions(const std::vector<Cache *> &caches)
+{
+    if (interconnect.getCaches().empty())
+    {
+        interconnect.setCaches(caches);
+        for (Cache *c : caches)
+            clusterCaches[interconnect.clusterOf(c->getProcessorId())].push_back(c);
+    }
+    ++cycle;
+
+    // Every cluster bus runs its cycle; the interconnect orders the
+    // messages they send by the cycle they leave.
+    totalBusTransactions = 0;
+    busInvalidations = 0;
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        clusters[i]->resolveTransactions(clusterCaches[i]);
+        totalBusTransactions += clusters[i]->getTotalBusTransactions();
+        busInvalidations += clusters[i]->getBusInvalidations();
+    }
+}
+
+bool ClusteredBus::hasPendingtransaction() const
+{
+    for (const auto &cluster : clusters)
+    {
+        if (cluster->hasPendingtransaction())
+            return true;
+    }
+    return false;
+}
+
+size_t ClusteredBus::getQueueDepth() const
+{
+    size_t depth = 0;
+    for (const auto &cluster : clusters)
+        depth += cluster->getQueueDepth();
+    return depth;
+}
+
+void ClusteredBus::skipIdleCycles(uint64_t n)
+{
+    Bus::skipIdleCycles(n);
+    for (auto &cluster : clusters)
+        cluster->skipIdleCycles(n);
+}
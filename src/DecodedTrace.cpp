@@ -0,0 +1,69 @@
+#include "DecodedTrace.hpp"
+#include "TraceParser.hpp"
+
+DecodedTraceSource::DecodedTraceSource(const std::string &traceFile, int b)
+    : b(b), total(0), runIndex(0), position(0)
+{
+    std::vector<Instruction> instructions = TraceParser::parseTraceFile(traceFile);
+    total = instructions.size();
+    for (const Instruction &inst : instructions)
+    {
+        uint32_t block = inst.address >> b;
+        // A compute gap starts a new run, so runs are always back to back.
+        // Atomics and fences are never charged as part of a run of hits.
+        bool special = (inst.op == OperationType::ATOMIC || inst.op == OperationType::FENCE);
+        if (runs.empty() || runs.back().block != block || runs.back().count == 64 || inst.gap > 0 ||
+            special || runs.back().special != OperationType::READ)
+            runs.push_back(BlockRun{block, 0, inst.gap, special ? inst.op : OperationType::READ, 0});
+        BlockRun &run = runs.back();
+        if (inst.op == OperationType::WRITE)
+            run.opMask |= (1ULL << run.count);
+        run.count++;
+    }
+    runs.shrink_to_fit();
+}
+
+bool DecodedTraceSource::next(Instruction &inst)
+{
+    if (runIndex >= runs.size())
+        return false;
+    const BlockRun &run = runs[runIndex];
+    inst.address = run.block << b;
+    if (run.special != OperationType::READ)
+        inst.op = run.special;
+    else
+        inst.op = ((run.opMask >> position) & 1) ? OperationType::WRITE : OperationType::READ;
+    inst.gap = (position == 0) ? run.gap : 0;
+    if (++position == run.count)
+    {
+        runIndex++;
+        position = 0;
+    }
+    return true;
+}
+
+// Runs split at 64 accesses may continue in the next record; only the
+// current record is reported.
+uint32_t DecodedTraceSource::runRemaining() const
+{
+    if (position == 0 || runIndex >= runs.size())
+        return 0;
+    return runs[runIndex].count - position;
+}
+
+uint64_t DecodedTraceSource::runWriteMask() const
+{
+    if (position == 0 || runIndex >= runs.size())
+        return 0;
+    return runs[runIndex].opMask >> position;
+}
+
+void DecodedTraceSource::skipRun(uint32_t n)
+{
+    position += n;
+    if (runIndex < runs.size() && position == runs[runIndex].count)
+    {
+        runIndex++;
+        position = 0;
+    }
+}
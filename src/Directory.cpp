@@ -0,0 +1,289 @@
+#include "Directory.hpp"
+#include "Cache.hpp"
+#include "EventTrace.hpp"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+bool parseDirectorySpec(const std::string &spec, DirectoryConfig &config)
+{
+    std::string kind = spec.substr(0, spec.find(':'));
+    if (kind == "full")
+        config.pointers = 0;
+    else if (kind == "limited")
+        config.pointers = 4;
+    else
+    {
+        std::cerr << "Unknown directory kind '" << kind << "' (expected full or limited)" << std::endl;
+        return false;
+    }
+
+    if (spec.find(':') == std::string::npos)
+        return true;
+
+    std::istringstream knobs(spec.substr(spec.find(':') + 1));
+    std::string knob;
+    while (std::getline(knobs, knob, ','))
+    {
+        size_t eq = knob.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Malformed directory knob '" << knob << "' (expected key=value)" << std::endl;
+            return false;
+        }
+        std::string key = knob.substr(0, eq);
+        int value;
+        try
+        {
+            value = std::stoi(knob.substr(eq + 1), nullptr, 0);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for directory knob '" << key << "': " << knob.substr(eq + 1) << std::endl;
+            return false;
+        }
+        if (value < 0 || (value == 0 && key != "hop" && key != "lookup"))
+        {
+            std::cerr << "Directory knob '" << key << "' out of range: " << value << std::endl;
+            return false;
+        }
+        if (key == "pointers" && kind == "limited")
+            config.pointers = value;
+        else if (key == "hop")
+            config.hopLatency = value;
+        else if (key == "flit")
+            config.flitBytes = value;
+        else if (key == "lookup")
+            config.lookupLatency = value;
+        else
+        {
+            std::cerr << "Unknown directory knob '" << key << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+Directory::Directory(const DirectoryConfig &config, int numCores, int blockSizeBytes)
+    : config(config),
+      numCores(numCores),
+      blockSizeBytes(blockSizeBytes),
+      dataFlits(1 + (blockSizeBytes + config.flitBytes - 1) / config.flitBytes),
+      mesh(numCores, config.hopLatency)
+{
+}
+
+void Directory::addTransaction(const BusTransaction &transaction)
+{
+    ++totalBusTransactions;
+    TRACE_EVENT(Bus, BusQueue, transaction.sourceProcessorId, transaction.address, transaction.type);
+    switch (transaction.type)
+    {
+    case BusTransactionType::BusUpgr:
+        busInvalidations++;
+        upgradeQueue.push_back(transaction);
+        break;
+    case BusTransactionType::BusWr:
+        // An owner's write-back while serving a forwarded request travels
+        // with the forwarded data, which serveRequest already sends.
+        if (!forwarding)
+            writebackQueue.push_back(transaction);
+        break;
+    default:
+        if (transaction.type != BusTransactionType::BusRd)
+            busInvalidations++;
+        pending.push_back(transaction);
+        pending.back().issueCycle = cycle;
+    }
+}
+
+bool Directory::hasPendingtransaction() const
+{
+    return !pending.empty() || !upgradeQueue.empty() || !writebackQueue.empty();
+}
+
+size_t Directory::getQueueDepth() const
+{
+    return pending.size() + upgradeQueue.size() + writebackQueue.size();
+}
+
+void Directory::addSharer(Entry &entry, int core)
+{
+    entry.sharers |= 1ULL << core;
+    if (config.pointers > 0 && __builtin_popcountll(entry.sharers) > config.pointers)
+        entry.overflow = true;
+}
+
+uint64_t Directory::invalidateSharers(Entry &entry, const BusTransaction &tx, uint64_t when,
+                                      const std::vector<Cache *> &caches)
+{
+    int requester = tx.sourceProcessorId;
+    uint64_t done = when;
+    if (entry.overflow)
+        broadcasts++;
+    for (int core = 0; core < numCores; ++core)
+    {
+        if (core == requester || core == entry.owner)
+            continue;
+        if (!entry.overflow && !(entry.sharers & (1ULL << core)))
+            continue;
+        invalidations++;
+        uint64_t arrive = mesh.send(homeOf(tx.address / blockSizeBytes), core, when, 1);
+        done = std::max(done, mesh.send(core, requester, arrive, 1));
+        if (tx.type == BusTransactionType::BusUpgr)
+            caches[core]->invalidateShared(tx.address);
+        else
+            caches[core]->handleBusTransaction(tx);
+    }
+    entry.sharers = 0;
+    entry.overflow = false;
+    return done;
+}
+
+//------------------------------------------------------------------
+void Directory::serveRequest(const BusTransaction &tx, Cache *src, const std::vector<Cache *> &caches)
+{
+    uint32_t block = tx.address / blockSizeBytes;
+    int requester = tx.sourceProcessorId;
+    int home = homeOf(block);
+    Entry &entry = entries[block];
+
+    uint64_t t = mesh.send(requester, home, cycle, 1) + config.lookupLatency;
+    uint64_t done;
+    bool shared = false;
+    int owner = (entry.owner != requester) ? entry.owner : -1;
+
+    // The owner answers a forwarded request if it still holds the block;
+    // otherwise (a silent clean eviction) it nacks and memory supplies it.
+    uint64_t ownerData = 0;
+    bool ownerSupplies = false;
+    if (owner >= 0)
+    {
+        forwards++;
+        uint64_t arrive = mesh.send(home, owner, t, 1);
+        Cache *o = caches[owner];
+        MESIState ownerState = o->getBlockState(tx.address);
+        if (ownerState != MESIState::Invalid)
+        {
+            ownerSupplies = true;
+            forwarding = true;
+            o->handleBusTransaction(tx);
+            forwarding = false;
+            o->is_writing_to_mem = false;
+            o->modified_invalidated = false;
+            ownerData = mesh.send(owner, requester, arrive, dataFlits);
+            // A dirty block also refreshes memory when it becomes shared.
+            if (ownerState == MESIState::Modified && tx.type == BusTransactionType::BusRd)
+                mesh.send(owner, home, arrive, dataFlits);
+        }
+        else
+        {
+            staleForwards++;
+            t = mesh.send(owner, home, arrive, 1);
+        }
+        entry.sharers &= ~(1ULL << owner);
+        entry.owner = -1;
+    }
+    if (!ownerSupplies)
+        ownerData = mesh.send(home, requester, t + memoryLatency, dataFlits);
+
+    if (tx.type == BusTransactionType::BusRd)
+    {
+        done = ownerData;
+        if (ownerSupplies)
+        {
+            shared = true;
+            addSharer(entry, owner);
+        }
+        else
+        {
+            shared = (entry.sharers & ~(1ULL << requester)) != 0 || entry.overflow;
+        }
+        addSharer(entry, requester);
+        if (!shared)
+            entry.owner = requester;
+    }
+    else
+    {
+        // Sharer bits go stale after silent evictions, so ask the caches
+        // whether the invalidations will find a copy.
+        shared = ownerSupplies;
+        for (int core = 0; core < numCores && !shared; ++core)
+            shared = core != requester && caches[core]->getBlockState(tx.address) != MESIState::Invalid;
+        done = std::max(ownerData, invalidateSharers(entry, tx, t, caches));
+        entry.sharers = 1ULL << requester;
+        entry.owner = requester;
+    }
+    entry.busyUntil = done;
+
+    int delay = static_cast<int>(std::max<uint64_t>(done - cycle, 1));
+    requests++;
+    totalRequestLatency += delay;
+    TRACE_EVENT(Bus, BusGrant, tx.sourceProcessorId, tx.address, delay);
+    src->resolvePendingTransaction(tx.type, tx.address, delay, shared);
+}
+
+void Directory::serveUpgrade(const BusTransaction &tx, const std::vector<Cache *> &caches)
+{
+    // The writer already holds the block Modified; the home only has to
+    // invalidate the other sharers.
+    uint32_t block = tx.address / blockSizeBytes;
+    int requester = tx.sourceProcessorId;
+    Entry &entry = entries[block];
+    uint64_t t = std::max(mesh.send(requester, homeOf(block), cycle, 1), entry.busyUntil) + config.lookupLatency;
+    entry.owner = -1;
+    entry.busyUntil = invalidateSharers(entry, tx, t, caches);
+    entry.sharers = 1ULL << requester;
+    entry.owner = requester;
+    upgrades++;
+}
+
+void Directory::serveWriteback(const BusTransaction &tx, const std::vector<Cache *> &caches)
+{
+    uint32_t block = tx.address / blockSizeBytes;
+    int writer = tx.sourceProcessorId;
+    mesh.send(writer, homeOf(block), cycle, dataFlits);
+    writebackMessages++;
+    Entry &entry = entries[block];
+    if (entry.owner == writer)
+        entry.owner = -1;
+    entry.sharers &= ~(1ULL << writer);
+    caches[writer]->is_writing_to_mem = false;
+    caches[writer]->modified_invalidated = false;
+}
+
+void Directory::resolveTransactions(const std::vector<Cache *> &caches)
+{
+    ++cycle;
+    mesh.setNow(cycle);
+
+    for (const auto &tx : writebackQueue)
+        serveWriteback(tx, caches);
+    writebackQueue.clear();
+
+    for (const auto &tx : upgradeQueue)
+        serveUpgrade(tx, caches);
+    upgradeQueue.clear();
+
+    // Waiting misses to different blocks start together; the network and
+    // the home nodes, not a single bus, decide how long each one takes.
+    // A miss to a block whose home is still serving an earlier request
+    // waits until that requester has its data, so it cannot steal the
+    // block before the earlier access retries.
+    // (Serving one may queue write-backs, which are served next cycle.)
+    starting.swap(pending);
+    for (const auto &tx : starting)
+    {
+        Cache *src = caches[tx.sourceProcessorId];
+        if (!src->isTransactionPending() || src->getPendingAddress() != tx.address ||
+            src->getPendingCycleCount() != -1)
+            continue;
+        auto it = entries.find(tx.address / blockSizeBytes);
+        if (it != entries.end() && it->second.busyUntil >= cycle)
+            pending.push_back(tx);
+        else
+            serveRequest(tx, src, caches);
+    }
+    starting.clear();
+}
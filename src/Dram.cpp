@@ -0,0 +1,125 @@
+#include "Dram.hpp"
+#include <iostream>
+#include <sstream>
+
+bool parseDramSpec(const std::string &spec, DramConfig &config)
+{
+    std::string policy = spec.substr(0, spec.find(':'));
+    if (policy == "open")
+        config.openPage = true;
+    else if (policy == "closed")
+        config.openPage = false;
+    else
+    {
+        std::cerr << "Unknown DRAM page policy '" << policy << "' (expected open or closed)" << std::endl;
+        return false;
+    }
+
+    if (spec.find(':') == std::string::npos)
+        return true;
+
+    std::istringstream knobs(spec.substr(spec.find(':') + 1));
+    std::string knob;
+    while (std::getline(knobs, knob, ','))
+    {
+        size_t eq = knob.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Malformed DRAM knob '" << knob << "' (expected key=value)" << std::endl;
+            return false;
+        }
+        std::string key = knob.substr(0, eq);
+        int value;
+        try
+        {
+            value = std::stoi(knob.substr(eq + 1), nullptr, 0);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for DRAM knob '" << key << "': " << knob.substr(eq + 1) << std::endl;
+            return false;
+        }
+        if (key == "banks")
+            config.banks = value;
+        else if (key == "row")
+            config.rowBytes = value;
+        else if (key == "trcd")
+            config.tRCD = value;
+        else if (key == "tcl")
+            config.tCL = value;
+        else if (key == "trp")
+            config.tRP = value;
+        else if (key == "burst")
+            config.burst = value;
+        else
+        {
+            std::cerr << "Unknown DRAM knob '" << key << "'" << std::endl;
+            return false;
+        }
+    }
+
+    if (config.banks < 1 || config.rowBytes < 1 || config.tRCD < 0 || config.tCL < 0 ||
+        config.tRP < 0 || config.burst < 1)
+    {
+        std::cerr << "DRAM banks, row size and burst must be positive and timings non-negative" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+Dram::Dram(const DramConfig &config)
+    : config(config),
+      banks(config.banks, Bank{false, 0, 0})
+{
+}
+
+bool Dram::isRowHit(uint32_t address) const
+{
+    const Bank &bank = banks[bankOf(address)];
+    return bank.open && bank.row == rowOf(address);
+}
+
+int Dram::access(uint32_t address, bool isWrite, uint64_t now)
+{
+    Bank &bank = banks[bankOf(address)];
+    uint32_t row = rowOf(address);
+    int wait = (bank.readyAt > now) ? static_cast<int>(bank.readyAt - now) : 0;
+
+    int latency;
+    if (bank.open && bank.row == row)
+    {
+        rowHits++;
+        latency = config.tCL + config.burst;
+    }
+    else if (bank.open)
+    {
+        rowConflicts++;
+        latency = config.tRP + config.tRCD + config.tCL + config.burst;
+    }
+    else
+    {
+        rowMisses++;
+        latency = config.tRCD + config.tCL + config.burst;
+    }
+
+    bank.readyAt = now + wait + latency;
+    if (config.openPage)
+    {
+        bank.open = true;
+        bank.row = row;
+    }
+    else
+    {
+        // Auto-precharge: the bank is busy closing the row afterwards.
+        bank.open = false;
+        bank.readyAt += config.tRP;
+    }
+
+    if (isWrite)
+        writes++;
+    else
+        reads++;
+    totalLatency += wait + latency;
+    return wait + latency;
+}
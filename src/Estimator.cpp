@@ -0,0 +1,280 @@
+#include "Estimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include "Cache.hpp"
+#include "Simulator.hpp"
+
+// Latencies of the base system (no --l2 or --dram), as in Bus.
+static const double MEMORY_CYCLES = 100.0;
+static const double WRITEBACK_CYCLES = 100.0;
+// Core cycles a miss costs on top of its bus transaction: the issue cycle
+// and the cycle the bus grants it.
+static const double MISS_OVERHEAD_CYCLES = 2.0;
+
+static const uint8_t INVALID = static_cast<uint8_t>(MESIState::Invalid);
+static const uint8_t SHARED = static_cast<uint8_t>(MESIState::Shared);
+static const uint8_t EXCLUSIVE = static_cast<uint8_t>(MESIState::Exclusive);
+static const uint8_t MODIFIED = static_cast<uint8_t>(MESIState::Modified);
+
+Estimator::Estimator(const SimulationConfig &config)
+    : s(config.s),
+      E(config.E),
+      b(config.b),
+      numCores(config.numCores),
+      caches(config.numCores, std::vector<Line>((1u << config.s) * config.E, Line{0, INVALID, 0})),
+      cores(config.numCores)
+{
+    for (int i = 0; i < numCores; ++i)
+    {
+        if (config.useWorkload)
+            sources.emplace_back(new SyntheticSource(config.workload, i));
+        else
+            sources.emplace_back(new TraceSource(config.tracePrefix + "_proc" + std::to_string(i) + ".trace"));
+    }
+}
+
+Estimator::Line *Estimator::find(int core, uint32_t address)
+{
+    uint32_t set = (address >> b) & ((1u << s) - 1);
+    uint32_t tag = address >> (s + b);
+    Line *ways = &caches[core][set * E];
+    for (int w = 0; w < E; ++w)
+    {
+        if (ways[w].state != INVALID && ways[w].tag == tag)
+            return &ways[w];
+    }
+    return nullptr;
+}
+
+void Estimator::busRequest(int core, double cycles)
+{
+    EstimateCoreStats &c = cores[core];
+    c.busRequests++;
+    c.busDemand += cycles;
+}
+
+void Estimator::install(int core, uint32_t address, uint8_t state)
+{
+    uint32_t set = (address >> b) & ((1u << s) - 1);
+    Line *ways = &caches[core][set * E];
+    Line *victim = &ways[0];
+    for (int w = 0; w < E; ++w)
+    {
+        if (ways[w].state == INVALID)
+        {
+            victim = &ways[w];
+            break;
+        }
+        if (ways[w].lastUse < victim->lastUse)
+            victim = &ways[w];
+    }
+    if (victim->state != INVALID)
+    {
+        cores[core].evictions++;
+        if (victim->state == MODIFIED)
+        {
+            // The evicting core stalls while its write-back holds the bus.
+            cores[core].writebacks++;
+            busRequest(core, WRITEBACK_CYCLES);
+        }
+    }
+    *victim = Line{address >> (s + b), state, ++useClock};
+}
+
+void Estimator::access(int core, const Instruction &inst)
+{
+    EstimateCoreStats &c = cores[core];
+    // Atomics take the block Modified like writes; fences only cost a cycle
+    // here, as there is no store buffer to drain.
+    bool isWrite = (inst.op != OperationType::READ);
+    c.instructions++;
+    c.localCycles += inst.gap;
+    if (inst.op == OperationType::FENCE)
+    {
+        c.localCycles += 1.0;
+        return;
+    }
+    if (inst.op == OperationType::WRITE)
+        c.writes++;
+    else if (inst.op == OperationType::READ)
+        c.reads++;
+
+    Line *line = find(core, inst.address);
+    if (line)
+    {
+        c.hits++;
+        c.localCycles += 1.0;
+        line->lastUse = ++useClock;
+        if (isWrite)
+        {
+            if (line->state == SHARED)
+            {
+                // BusUpgr: invalidations are applied without holding the bus.
+                c.upgrades++;
+                c.invalidations++;
+                for (int other = 0; other < numCores; ++other)
+                {
+                    Line *copy = (other == core) ? nullptr : find(other, inst.address);
+                    if (copy)
+                        copy->state = INVALID;
+                }
+            }
+            line->state = MODIFIED;
+        }
+        return;
+    }
+
+    // Miss: snoop the other caches as the bus would.
+    bool otherCopy = false;
+    bool dirtyCopy = false;
+    for (int other = 0; other < numCores; ++other)
+    {
+        Line *copy = (other == core) ? nullptr : find(other, inst.address);
+        if (!copy)
+            continue;
+        otherCopy = true;
+        if (copy->state == MODIFIED)
+        {
+            // The owner writes the block back and stalls meanwhile.
+            dirtyCopy = true;
+            cores[other].writebacks++;
+            cores[other].dataTrafficBytes += 1u << b;
+            cores[other].localCycles += WRITEBACK_CYCLES;
+        }
+        if (isWrite)
+            copy->state = INVALID;
+        else if (copy->state == MODIFIED || copy->state == EXCLUSIVE)
+            copy->state = SHARED;
+    }
+
+    // BusRd is served by any other copy (2 cycles per word); BusRdWITWr
+    // always by memory. Either waits for a snooped write-back first.
+    double fill;
+    if (!isWrite && otherCopy)
+    {
+        c.cacheToCacheFills++;
+        fill = 2.0 * ((1u << b) / 4);
+    }
+    else
+    {
+        c.memoryFills++;
+        fill = MEMORY_CYCLES;
+    }
+    if (dirtyCopy)
+        fill += WRITEBACK_CYCLES;
+    if (isWrite)
+        c.invalidations++;
+    c.dataTrafficBytes += 1u << b;
+    c.localCycles += MISS_OVERHEAD_CYCLES;
+    busRequest(core, fill);
+    install(core, inst.address, isWrite ? MODIFIED : (otherCopy ? SHARED : EXCLUSIVE));
+}
+
+void Estimator::run()
+{
+    // Cores advance in order of their uncontended local time, so that
+    // sharing patterns interleave roughly as they would on the bus.
+    std::vector<bool> done(numCores, false);
+    int remaining = numCores;
+    Instruction inst;
+    while (remaining > 0)
+    {
+        int next = -1;
+        for (int i = 0; i < numCores; ++i)
+        {
+            if (!done[i] && (next < 0 || cores[i].executionCycles() < cores[next].executionCycles()))
+                next = i;
+        }
+        if (!sources[next]->next(inst))
+        {
+            done[next] = true;
+            remaining--;
+            continue;
+        }
+        access(next, inst);
+    }
+    solveQueueingModel();
+}
+
+//------------------------------------------------------------------
+// Schweitzer's approximate MVA with one customer per class. A request
+// from core c waits for the transactions other cores have at the bus:
+//   wait_c = sum_{j != c} Q_j * S_j
+// where Q_j is core j's mean number of transactions at the bus and S_j
+// their mean holding time. Charging a full holding time for the one in
+// service (rather than a deterministic residual of half) matches the bus
+// better: in a closed system a core re-arrives right after its own
+// transaction, just as another one is granted.
+void Estimator::solveQueueingModel()
+{
+    // Start from the uncontended run.
+    std::vector<double> queue(numCores, 0.0);
+    for (int i = 0; i < numCores; ++i)
+    {
+        const EstimateCoreStats &c = cores[i];
+        if (c.executionCycles() > 0.0)
+            queue[i] = c.busDemand / c.executionCycles();
+    }
+    modelIterations = 0;
+    for (int iteration = 0; iteration < 10000; ++iteration)
+    {
+        modelIterations = iteration + 1;
+        double change = 0.0;
+        for (int i = 0; i < numCores; ++i)
+        {
+            EstimateCoreStats &c = cores[i];
+            double wait = 0.0;
+            for (int j = 0; j < numCores; ++j)
+            {
+                const EstimateCoreStats &other = cores[j];
+                if (j == i || other.busRequests == 0)
+                    continue;
+                wait += queue[j] * (other.busDemand / other.busRequests);
+            }
+            double busWait = c.busRequests * wait;
+            change = std::max(change, std::fabs(busWait - c.busWait) / std::max(1.0, c.totalCycles()));
+            c.busWait = busWait;
+        }
+        for (int i = 0; i < numCores; ++i)
+        {
+            const EstimateCoreStats &c = cores[i];
+            double cycle = c.totalCycles();
+            queue[i] = (cycle > 0.0) ? (c.busDemand + c.busWait) / cycle : 0.0;
+        }
+        if (change < 1e-9)
+            break;
+    }
+}
+
+uint64_t Estimator::getBusTransactions() const
+{
+    uint64_t total = 0;
+    for (const EstimateCoreStats &c : cores)
+        total += c.misses() + c.upgrades + c.writebacks;
+    return total;
+}
+
+uint64_t Estimator::getBusTrafficBytes() const
+{
+    uint64_t total = 0;
+    for (const EstimateCoreStats &c : cores)
+        total += c.dataTrafficBytes;
+    return total;
+}
+
+double Estimator::getEstimatedCycles() const
+{
+    double slowest = 0.0;
+    for (const EstimateCoreStats &c : cores)
+        slowest = std::max(slowest, c.totalCycles());
+    return slowest;
+}
+
+double Estimator::getBusUtilization() const
+{
+    double demand = 0.0;
+    for (const EstimateCoreStats &c : cores)
+        demand += c.busDemand;
+    double cycles = getEstimatedCycles();
+    return (cycles > 0.0) ? std::min(1.0, demand / cycles) : 0.0;
+}
@@ -0,0 +1,198 @@
+#include "EventTrace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+EventTracer *EventTracer::active = nullptr;
+std::atomic<uint64_t> EventTracer::cycle(0);
+thread_local uint64_t EventTracer::threadCycle = UINT64_MAX;
+
+static const uint32_t traceFileVersion = 1;
+
+bool parseTraceCores(const std::string &list, uint64_t &mask)
+{
+    mask = 0;
+    std::istringstream cores(list);
+    std::string core;
+    while (std::getline(cores, core, ','))
+    {
+        int id = -1;
+        try
+        {
+            id = std::stoi(core);
+        }
+        catch (const std::exception &)
+        {
+        }
+        if (id < 0 || id >= 64)
+        {
+            std::cerr << "Invalid core '" << core << "' in trace core list (expected 0-63)" << std::endl;
+            return false;
+        }
+        mask |= 1ULL << id;
+    }
+    return mask != 0;
+}
+
+bool parseTraceRange(const std::string &range, uint64_t &low, uint64_t &high)
+{
+    size_t dash = range.find('-');
+    try
+    {
+        if (dash == std::string::npos)
+            throw std::invalid_argument(range);
+        low = std::stoull(range.substr(0, dash), nullptr, 0);
+        high = std::stoull(range.substr(dash + 1), nullptr, 0);
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Malformed range '" << range << "' (expected <low>-<high>)" << std::endl;
+        return false;
+    }
+    if (low > high)
+    {
+        std::cerr << "Empty range '" << range << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char *traceCategoryName(TraceCategory category)
+{
+    switch (category)
+    {
+    case TraceCategory::Cache:
+        return "cache";
+    case TraceCategory::Snoop:
+        return "snoop";
+    case TraceCategory::Bus:
+        return "bus";
+    case TraceCategory::Processor:
+        return "processor";
+    default:
+        return "unknown";
+    }
+}
+
+const char *traceEventName(TraceEvent event)
+{
+    switch (event)
+    {
+    case TraceEvent::CacheHit:
+        return "hit";
+    case TraceEvent::CacheMiss:
+        return "miss";
+    case TraceEvent::CacheFill:
+        return "fill";
+    case TraceEvent::CacheEvict:
+        return "evict";
+    case TraceEvent::SnoopDowngrade:
+        return "downgrade";
+    case TraceEvent::SnoopInvalidate:
+        return "invalidate";
+    case TraceEvent::BusQueue:
+        return "queue";
+    case TraceEvent::BusGrant:
+        return "grant";
+    case TraceEvent::ProcRetire:
+        return "retire";
+    default:
+        return "unknown";
+    }
+}
+
+//------------------------------------------------------------------
+EventTracer::EventTracer(const std::string &path, const TraceFilter &filter, size_t capacityRecords)
+    : file(std::fopen(path.c_str(), "wb")),
+      filter(filter),
+      head(0),
+      tail(0),
+      stopping(false)
+{
+    // Round the capacity up to a power of two so slots are head & mask.
+    size_t capacity = 1;
+    while (capacity < capacityRecords)
+        capacity <<= 1;
+    ring.resize(capacity);
+    mask = capacity - 1;
+    if (!file)
+        return;
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, "L1EVENT", 8);
+    header.version = traceFileVersion;
+    header.recordBytes = sizeof(TraceRecord);
+    std::fwrite(&header, sizeof(header), 1, file);
+    writer = std::thread(&EventTracer::writerLoop, this);
+}
+
+EventTracer::~EventTracer()
+{
+    if (active == this)
+        active = nullptr;
+    if (!file)
+        return;
+    stopping.store(true, std::memory_order_release);
+    wake.notify_one();
+    writer.join();
+    std::fclose(file);
+}
+
+void EventTracer::record(TraceCategory category, TraceEvent event, int core, uint32_t address, uint32_t arg)
+{
+    uint64_t now = (threadCycle != UINT64_MAX) ? threadCycle : cycle.load(std::memory_order_relaxed);
+    if (core >= 0 && core < 64 && !((filter.coreMask >> core) & 1))
+        return;
+    if (address < filter.addressLow || address > filter.addressHigh ||
+        now < filter.cycleFrom || now > filter.cycleTo)
+        return;
+
+    std::lock_guard<std::mutex> guard(producerLock);
+    uint64_t slot = head.load(std::memory_order_relaxed);
+    if (slot - tail.load(std::memory_order_acquire) == ring.size())
+    {
+        producerStalls++;
+        wake.notify_one();
+        while (slot - tail.load(std::memory_order_acquire) == ring.size())
+            std::this_thread::yield();
+    }
+    TraceRecord &r = ring[slot & mask];
+    r.cycle = now;
+    r.address = address;
+    r.arg = arg;
+    r.core = static_cast<int16_t>(core);
+    r.category = static_cast<uint8_t>(category);
+    r.event = static_cast<uint8_t>(event);
+    r.reserved = 0;
+    head.store(slot + 1, std::memory_order_release);
+    // Wake the writer each time half a buffer has filled.
+    if (((slot + 1) & (mask >> 1)) == 0)
+        wake.notify_one();
+}
+
+void EventTracer::writerLoop()
+{
+    while (true)
+    {
+        uint64_t start = tail.load(std::memory_order_relaxed);
+        uint64_t end = head.load(std::memory_order_acquire);
+        if (start == end)
+        {
+            // Producers are done once stopping is set, so an empty buffer
+            // then means everything has been written.
+            if (stopping.load(std::memory_order_acquire) &&
+                head.load(std::memory_order_acquire) == start)
+                break;
+            std::unique_lock<std::mutex> lock(wakeLock);
+            wake.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+        // Write the filled slots, split where they wrap around the ring.
+        size_t first = start & mask;
+        size_t count = static_cast<size_t>(std::min<uint64_t>(end - start, ring.size() - first));
+        std::fwrite(&ring[first], sizeof(TraceRecord), count, file);
+        tail.store(start + count, std::memory_order_release);
+    }
+}
@@ -0,0 +1,57 @@
+#include "L2Cache.hpp"
+
+L2Cache::L2Cache(int s, int E, int b, int hitLatency, bool inclusive)
+    : s(s),
+      E(E),
+      b(b),
+      numSets(1 << s),
+      blockSizeBytes(1 << b),
+      hitLatency(hitLatency),
+      inclusive(inclusive),
+      lines(E, (1 << s))
+{
+}
+
+//------------------------------------------------------------------
+bool L2Cache::access(uint32_t address, bool isWrite, std::vector<uint32_t> &backInvalidations,
+                     std::vector<uint32_t> &writebacks)
+{
+    int setIndex = (address >> b) & (numSets - 1);
+    uint32_t tag = address >> (s + b);
+
+    int way = lines.findWay(setIndex, tag, E);
+    if (way >= 0)
+    {
+        hits++;
+        if (isWrite)
+            lines.meta[setIndex][way].dirty = true;
+        lines.touch(setIndex, way, E);
+        return true;
+    }
+
+    misses++;
+    int victim = lines.pickVictim(setIndex, E);
+    CacheLineMeta &line = lines.meta[setIndex][victim];
+    if (line.valid)
+    {
+        evictions++;
+        uint32_t victimAddr = lines.blockAddress(setIndex, victim, s, b);
+        if (line.dirty)
+        {
+            writebacks.push_back(victimAddr);
+            writebackCount++;
+        }
+        if (inclusive)
+        {
+            backInvalidations.push_back(victimAddr);
+            backInvalidationCount++;
+        }
+    }
+
+    lines.tagArray.tags[setIndex][victim] = tag;
+    line.valid = true;
+    line.dirty = isWrite;
+    line.state = isWrite ? MESIState::Modified : MESIState::Exclusive;
+    lines.touch(setIndex, victim, E);
+    return false;
+}
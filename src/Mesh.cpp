@@ -0,0 +1,73 @@
+#include "Mesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+Mesh::Mesh(int numNodes, int hopLatency)
+    : hopLatency(hopLatency)
+{
+    cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numNodes))));
+    rows = (numNodes + cols - 1) / cols;
+    linkBookings.assign(rows * cols * 4, {});
+}
+
+int Mesh::hops(int from, int to) const
+{
+    return std::abs(from % cols - to % cols) + std::abs(from / cols - to / cols);
+}
+
+uint64_t Mesh::reserve(std::vector<Booking> &link, uint64_t when, int cycles)
+{
+    size_t expired = 0;
+    while (expired < link.size() && link[expired].end <= now)
+        expired++;
+    link.erase(link.begin(), link.begin() + expired);
+
+    uint64_t start = when;
+    size_t i = 0;
+    for (; i < link.size(); ++i)
+    {
+        if (start + cycles <= link[i].start)
+            break;
+        start = std::max(start, link[i].end);
+    }
+    link.insert(link.begin() + i, Booking{start, start + cycles});
+    contentionCycles += start - when;
+    return start;
+}
+
+uint64_t Mesh::send(int from, int to, uint64_t when, int messageFlits)
+{
+    messages++;
+    flits += messageFlits;
+    if (from == to)
+        return when;
+
+    // Walk the XY route: the head flit waits for each link, then moves on
+    // after hopLatency; the body streams behind it one flit per cycle.
+    uint64_t t = when;
+    int node = from;
+    while (node != to)
+    {
+        int x = node % cols, y = node / cols;
+        int tx = to % cols, ty = to / cols;
+        Port port;
+        int next;
+        if (x != tx)
+        {
+            port = (tx > x) ? East : West;
+            next = node + ((tx > x) ? 1 : -1);
+        }
+        else
+        {
+            port = (ty > y) ? South : North;
+            next = node + ((ty > y) ? cols : -cols);
+        }
+        t = reserve(linkBookings[node * 4 + port], t, messageFlits) + hopLatency;
+        flitHops += messageFlits;
+        node = next;
+    }
+    uint64_t arrival = t + messageFlits - 1;
+    totalLatency += arrival - when;
+    return arrival;
+}
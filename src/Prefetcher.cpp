@@ -0,0 +1,156 @@
+#include "Prefetcher.hpp"
+#include <cstdlib>
+
+bool parsePrefetcherKind(const std::string &name, PrefetcherKind &kind)
+{
+    if (name == "none")
+        kind = PrefetcherKind::None;
+    else if (name == "nextline")
+        kind = PrefetcherKind::NextLine;
+    else if (name == "stride")
+        kind = PrefetcherKind::Stride;
+    else if (name == "stream")
+        kind = PrefetcherKind::Stream;
+    else
+        return false;
+    return true;
+}
+
+const char *prefetcherKindName(PrefetcherKind kind)
+{
+    switch (kind)
+    {
+    case PrefetcherKind::NextLine:
+        return "Next-line";
+    case PrefetcherKind::Stride:
+        return "Stride";
+    case PrefetcherKind::Stream:
+        return "Stream buffers";
+    default:
+        return "None";
+    }
+}
+
+Prefetcher *Prefetcher::create(PrefetcherKind kind, int degree)
+{
+    switch (kind)
+    {
+    case PrefetcherKind::NextLine:
+        return new NextLinePrefetcher(degree);
+    case PrefetcherKind::Stride:
+        return new StridePrefetcher(degree);
+    case PrefetcherKind::Stream:
+        return new StreamPrefetcher(degree);
+    default:
+        return nullptr;
+    }
+}
+
+//------------------------------------------------------------------
+void NextLinePrefetcher::onMiss(uint32_t block, std::vector<uint32_t> &candidates)
+{
+    for (int i = 1; i <= degree; ++i)
+        candidates.push_back(block + i);
+}
+
+// Tagged next-line: a first use of a prefetched block triggers the next one.
+void NextLinePrefetcher::onPrefetchHit(uint32_t block, std::vector<uint32_t> &candidates)
+{
+    candidates.push_back(block + degree);
+}
+
+//------------------------------------------------------------------
+void StridePrefetcher::onMiss(uint32_t block, std::vector<uint32_t> &candidates)
+{
+    if (hasLast)
+    {
+        int64_t stride = static_cast<int64_t>(block) - static_cast<int64_t>(lastBlock);
+        confirmed = (stride != 0 && stride == lastStride);
+        lastStride = stride;
+        if (confirmed)
+        {
+            for (int i = 1; i <= degree; ++i)
+                candidates.push_back(static_cast<uint32_t>(block + stride * i));
+        }
+    }
+    hasLast = true;
+    lastBlock = block;
+}
+
+//------------------------------------------------------------------
+StreamPrefetcher::StreamPrefetcher(int degree, int numStreams)
+    : degree(degree), streams(numStreams)
+{
+}
+
+void StreamPrefetcher::runAhead(Stream &stream, uint32_t block, std::vector<uint32_t> &candidates)
+{
+    stream.lastBlock = block;
+    stream.lastUse = ++useClock;
+    uint32_t limit = block + stream.direction * degree;
+    if (stream.direction > 0 && stream.head <= block)
+        stream.head = block + 1;
+    if (stream.direction < 0 && stream.head >= block)
+        stream.head = block - 1;
+    while ((stream.direction > 0) ? stream.head <= limit : stream.head >= limit)
+    {
+        candidates.push_back(stream.head);
+        stream.head += stream.direction;
+    }
+}
+
+void StreamPrefetcher::onMiss(uint32_t block, std::vector<uint32_t> &candidates)
+{
+    // A miss within `degree` blocks of a stream's last demand continues it.
+    // A stream's second miss may also turn it around to descend.
+    for (auto &stream : streams)
+    {
+        if (!stream.valid)
+            continue;
+        int64_t delta = static_cast<int64_t>(block) - static_cast<int64_t>(stream.lastBlock);
+        if (!stream.trained && delta < 0 && -delta <= degree + 1)
+        {
+            stream.direction = -1;
+            stream.head = block - 1;
+        }
+        if (delta * stream.direction > 0 && delta * stream.direction <= degree + 1)
+        {
+            stream.trained = true;
+            runAhead(stream, block, candidates);
+            return;
+        }
+    }
+
+    // Otherwise allocate the least recently used tracker, ascending.
+    Stream *victim = &streams[0];
+    for (auto &stream : streams)
+    {
+        if (!stream.valid)
+        {
+            victim = &stream;
+            break;
+        }
+        if (stream.lastUse < victim->lastUse)
+            victim = &stream;
+    }
+    victim->valid = true;
+    victim->trained = false;
+    victim->direction = 1;
+    victim->head = block + 1;
+    runAhead(*victim, block, candidates);
+}
+
+void StreamPrefetcher::onPrefetchHit(uint32_t block, std::vector<uint32_t> &candidates)
+{
+    for (auto &stream : streams)
+    {
+        if (!stream.valid)
+            continue;
+        int64_t distance = (static_cast<int64_t>(block) - static_cast<int64_t>(stream.lastBlock)) * stream.direction;
+        if (distance > 0 && distance <= degree + 1)
+        {
+            runAhead(stream, block, candidates);
+            return;
+        }
+    }
+}
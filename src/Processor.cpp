@@ -1,6 +1,9 @@
 #include "Processor.hpp"
+#include "EventTrace.hpp"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <climits>
 
 Processor::Processor(int id,
                      const std::string &traceFile,
@@ -17,13 +20,73 @@ Processor::Processor(int id,
     loadTrace(traceFile);
 }
 
+Processor::Processor(int id,
+                     InstructionSource *instructionSource,
+                     Cache *cache,
+                     Bus *busPtr)
+    : processorId(id),
+      l1Cache(cache),
+      bus(busPtr),
+      source(instructionSource),
+      currentInstructionIndex(0),
+      stallCounter(0),
+      totalCycles(0),
+      idleCycles(0)
+{
+    hasCurrent = source->next(current);
+}
+
 void Processor::loadTrace(const std::string &traceFile)
 {
-    instructions = TraceParser::parseTraceFile(traceFile);
+    source.reset(new TraceSource(traceFile));
+    hasCurrent = source->next(current);
+}
+
+void Processor::setSource(InstructionSource *newSource)
+{
+    source.reset(newSource);
+    lookahead.clear();
+    hasCurrent = source->next(current);
+    translated = false;
+}
+
+void Processor::resume()
+{
+    if (!hasCurrent)
+    {
+        fetch();
+        translated = false;
+    }
+}
+
+void Processor::advance()
+{
+    TRACE_EVENT(Processor, ProcRetire, processorId, current.address, current.op);
+    currentInstructionIndex++;
+    fetch();
+    translated = false;
+}
+
+void Processor::fetch()
+{
+    if (lookahead.empty())
+    {
+        hasCurrent = source->next(current);
+        return;
+    }
+    current = lookahead.front();
+    lookahead.pop_front();
+    hasCurrent = true;
 }
 
 void Processor::executeCycle()
 {
+    if (storeBufferCapacity > 0)
+    {
+        executeBufferedCycle();
+        return;
+    }
+
     // 0) If _this_ core is the one doing a 100-cycle write-back, stall:
     if (bus->getPendingBusWr() &&
     bus->getPendingBusWrSource() == processorId)
@@ -41,20 +104,39 @@ void Processor::executeCycle()
             idleCycles++;
         }
         l1Cache->decrementPendingCycle();
-        
+        // The atomic retires as its fill completes (see executeAtomic).
+        if (atomicIssued && !l1Cache->isTransactionPending() && executeAtomic())
+            advance();
+
         totalCycles++;
         return;
     }
 
     // If no more instructions, just increment cycles
-    if (currentInstructionIndex >= instructions.size())
+    if (!hasCurrent)
     {
         // totalCycles++;
         return;
     }
 
+    // Non-memory work before the access.
+    if (current.gap > 0)
+    {
+        current.gap--;
+        computeCycles++;
+        totalCycles++;
+        return;
+    }
+
+    // The access waits for its translation.
+    if (tlb && !translated && current.op != OperationType::FENCE && !translate())
+    {
+        totalCycles++;
+        return;
+    }
+
     // Get the current instruction
-    Instruction &instr = instructions[currentInstructionIndex];
+    Instruction &instr = current;
     int dummy = 0;
     bool hit = false;
 
@@ -64,7 +146,12 @@ void Processor::executeCycle()
         if (hit || !l1Cache->isTransactionPending()) {
             // Instruction completed or no transaction started
             totalReadInstructions++;
-            currentInstructionIndex++; // Only advance if instruction completed
+            countLockRead(instr.address, false);
+            advance(); // Only advance if instruction completed
+        }
+        else
+        {
+            countLockRead(instr.address, true);
         }
     }
     else if (instr.op == OperationType::WRITE)
@@ -73,26 +160,428 @@ void Processor::executeCycle()
         if (hit || !l1Cache->isTransactionPending()) {
             // Instruction completed or no transaction started
             totalWriteInstructions++;
-            currentInstructionIndex++; // Only advance if instruction completed
+            advance(); // Only advance if instruction completed
         }
     }
+    else if (instr.op == OperationType::ATOMIC)
+    {
+        if (executeAtomic())
+            advance();
+    }
+    else
+    {
+        // Without a store buffer nothing is outstanding once the core
+        // issues again, so a fence retires at once.
+        totalFences++;
+        advance();
+    }
 
     totalCycles++; // one core cycle always elapses
 }
 
+// A miss performs the read-modify-write when the bus grants its BusRdWITWr
+// and installs the block Modified; the atomic then only waits out the fill
+// latency. Re-checking the block afterwards would let two cores spinning on
+// one lock steal it from each other forever. A victim cache swap-in is the
+// exception: it refills the line in its old state without the bus, so the
+// atomic is issued again, as a read or write is re-executed.
+bool Processor::executeAtomic()
+{
+    if (!atomicIssued)
+    {
+        atomicStart = totalCycles;
+        int dummy = 0;
+        if (!l1Cache->atomic(current.address, dummy, bus) && l1Cache->isTransactionPending())
+        {
+            atomicIssued = true;
+            return false;
+        }
+    }
+    else if (l1Cache->isTransactionPending())
+    {
+        return false;
+    }
+    else if (l1Cache->lastFillWasSwap())
+    {
+        int dummy = 0;
+        if (!l1Cache->atomic(current.address, dummy, bus) && l1Cache->isTransactionPending())
+            return false;
+    }
+    LockCounters &lock = locks[current.address & ~(l1Cache->getBlockSizeBytes() - 1u)];
+    lock.atomics++;
+    lock.contendedAtomics += (atomicIssued && l1Cache->lastFillWasShared()) ? 1 : 0;
+    lock.atomicCycles += totalCycles - atomicStart + 1;
+    totalAtomics++;
+    atomicIssued = false;
+    return true;
+}
+
+void Processor::countLockRead(uint32_t address, bool missed)
+{
+    if (locks.empty())
+        return;
+    auto it = locks.find(address & ~(l1Cache->getBlockSizeBytes() - 1u));
+    if (it == locks.end())
+        return;
+    if (missed)
+        it->second.spinMisses++;
+    else
+        it->second.spinReads++;
+}
+
+uint64_t Processor::getComputeCyclesAhead() const
+{
+    if (!hasCurrent || l1Cache->isTransactionPending() || !storeBuffer.empty() ||
+        (bus->getPendingBusWr() && bus->getPendingBusWrSource() == processorId))
+        return 0;
+    return current.gap;
+}
+
+void Processor::skipCompute(uint64_t n)
+{
+    current.gap -= static_cast<uint32_t>(n);
+    computeCycles += n;
+    totalCycles += n;
+}
+
+uint64_t Processor::getLocalCyclesAhead() const
+{
+    uint64_t compute = getComputeCyclesAhead();
+    if (compute > 0)
+        return compute;
+    if (!hasCurrent || tlb || l1Cache->isTransactionPending() || source->runRemaining() == 0 ||
+        (bus->getPendingBusWr() && bus->getPendingBusWrSource() == processorId) ||
+        !l1Cache->hitsLocally(current.address, current.op != OperationType::READ))
+        return 0;
+    return runLength(INT_MAX);
+}
+
+void Processor::skipLocal(uint64_t n)
+{
+    if (current.gap > 0)
+        skipCompute(n);
+    else if (chargeRun(static_cast<int>(n)) == 0)
+        executeCycle(); // n == 1: a single hit.
+}
+
+//------------------------------------------------------------------
+bool Processor::translate()
+{
+    if (walkLevel < 0)
+    {
+        uint32_t physical;
+        if (tlb->lookup(current.address, physical))
+        {
+            current.address = physical;
+            translated = true;
+            return true;
+        }
+        walkLevel = 0;
+        walkPenaltyLeft = tlb->getMissPenalty();
+        walkStart = totalCycles;
+    }
+    // One page table entry per level, read through the L1 like any load;
+    // a miss is retried (and hits) once the fill completes.
+    if (walkLevel < tlb->getLevels())
+    {
+        int dummy = 0;
+        if (l1Cache->read(tlb->pteAddress(current.address, walkLevel), dummy, bus) ||
+            !l1Cache->isTransactionPending())
+        {
+            tlb->countPageTableRead();
+            walkLevel++;
+        }
+        return false;
+    }
+    if (walkPenaltyLeft > 0)
+    {
+        walkPenaltyLeft--;
+        return false;
+    }
+    current.address = tlb->fill(current.address, totalCycles - walkStart);
+    walkLevel = -1;
+    translated = true;
+    return true;
+}
+
+bool Processor::forwardsFromStoreBuffer(uint32_t address) const
+{
+    uint32_t word = address & ~3u;
+    for (uint32_t stored : storeBuffer)
+    {
+        if ((stored & ~3u) == word)
+            return true;
+    }
+    return false;
+}
+
+// One cycle with a store buffer. The L1 handles one miss at a time: each
+// cycle the port serves either the core's load or, if the core does not need
+// it, the store at the head of the buffer. While a drained store misses,
+// loads that hit still proceed. Stores leave the buffer strictly in order
+// and loads may pass them (TSO).
+void Processor::executeBufferedCycle()
+{
+    // 0) Same as executeCycle: stall while this core's write-back holds the bus.
+    if (bus->getPendingBusWr() &&
+        bus->getPendingBusWrSource() == processorId)
+    {
+        totalCycles++;
+        return;
+    }
+
+    // 1) An outstanding miss (load or draining store) keeps the port busy.
+    bool portBusy = l1Cache->isTransactionPending();
+    bool waitingForGrant = false;
+    if (portBusy)
+    {
+        waitingForGrant = (l1Cache->getPendingCycleCount() == -1);
+        l1Cache->decrementPendingCycle();
+        // As in executeCycle, an atomic completes with its fill.
+        if (atomicIssued && !l1Cache->isTransactionPending())
+            portBusy = false;
+    }
+
+    if (!hasCurrent && storeBuffer.empty())
+    {
+        if (portBusy)
+            totalCycles++;
+        return;
+    }
+
+    // 2) The core's instruction. Compute cycles leave the port to the drain.
+    bool retired = false;
+    bool usedPort = false;
+    bool computing = false;
+    int dummy = 0;
+    if (hasCurrent)
+    {
+        if (current.gap > 0)
+        {
+            current.gap--;
+            computeCycles++;
+            computing = true;
+        }
+        else if (current.op == OperationType::FENCE)
+        {
+            // Waits for every buffered store, and any miss they started.
+            if (storeBuffer.empty() && !portBusy)
+            {
+                totalFences++;
+                retired = true;
+            }
+            else
+            {
+                fenceStallCycles++;
+            }
+        }
+        else if (current.op == OperationType::ATOMIC)
+        {
+            // Atomics are full fences under TSO: the buffer drains first.
+            if (!storeBuffer.empty())
+            {
+                fenceStallCycles++;
+            }
+            else if (!portBusy)
+            {
+                usedPort = true;
+                drainMissPending = false;
+                retired = executeAtomic();
+            }
+        }
+        else if (current.op == OperationType::WRITE)
+        {
+            if (static_cast<int>(storeBuffer.size()) < storeBufferCapacity)
+            {
+                storeBuffer.push_back(current.address);
+                storesBuffered++;
+                totalWriteInstructions++;
+                retired = true;
+            }
+            else
+            {
+                storeBufferFullStalls++;
+            }
+        }
+        else if (forwardsFromStoreBuffer(current.address))
+        {
+            loadsForwarded++;
+            totalReadInstructions++;
+            countLockRead(current.address, false);
+            retired = true;
+        }
+        else if (portBusy && drainMissPending)
+        {
+            // Hit under the draining store's miss: the fill does not block
+            // loads that find their block already present.
+            if (l1Cache->readHit(current.address))
+            {
+                totalReadInstructions++;
+                countLockRead(current.address, false);
+                retired = true;
+            }
+        }
+        else if (!portBusy)
+        {
+            usedPort = true;
+            drainMissPending = false;
+            if (l1Cache->read(current.address, dummy, bus) || !l1Cache->isTransactionPending())
+            {
+                totalReadInstructions++;
+                countLockRead(current.address, false);
+                retired = true;
+            }
+            else
+            {
+                countLockRead(current.address, true);
+            }
+        }
+        if (!retired && !computing && waitingForGrant)
+            idleCycles++;
+    }
+
+    // 3) Drain the head store if the port is still free. A miss leaves the
+    // store at the head; it is re-tried (and hits) once the fill completes.
+    if (!portBusy && !usedPort && !storeBuffer.empty())
+    {
+        if (l1Cache->write(storeBuffer.front(), dummy, bus) || !l1Cache->isTransactionPending())
+        {
+            storeBuffer.pop_front();
+            drainMissPending = false;
+        }
+        else
+        {
+            drainMissPending = true;
+        }
+    }
+
+    if (retired)
+    {
+        if (portBusy && drainMissPending)
+            storeStallCyclesSaved++;
+        advance();
+    }
+    totalCycles++;
+}
+
+uint64_t Processor::localHorizon(uint64_t maxCycles)
+{
+    // Buffered cycles interleave drains with the core, and a pending fill
+    // finishes on the bus, so both are left to the serial loop.
+    if (storeBufferCapacity > 0 || !hasCurrent || l1Cache->isTransactionPending() ||
+        (bus->getPendingBusWr() && bus->getPendingBusWrSource() == processorId))
+        return 0;
+    // Hits change no line's presence and leave writable lines writable, so
+    // every access in the window can be checked against today's L1.
+    uint64_t cycles = 0;
+    const Instruction *inst = &current;
+    bool physical = translated;
+    size_t fetched = 0;
+    while (true)
+    {
+        cycles += inst->gap;
+        if (cycles >= maxCycles)
+            return maxCycles;
+        if (inst->op != OperationType::FENCE)
+        {
+            uint32_t address = inst->address;
+            // TLB misses walk through the bus.
+            if (tlb && !physical && !tlb->contains(inst->address, address))
+                return cycles;
+            if (!l1Cache->hitsLocally(address, inst->op != OperationType::READ))
+                return cycles;
+        }
+        if (++cycles >= maxCycles)
+            return maxCycles;
+        if (fetched == lookahead.size())
+        {
+            Instruction next;
+            if (!source->next(next))
+                return cycles;
+            lookahead.push_back(next);
+        }
+        inst = &lookahead[fetched++];
+        physical = false;
+    }
+}
+
+void Processor::runLocal(uint64_t n)
+{
+    uint64_t cycles = 0;
+    while (cycles < n && hasCurrent)
+    {
+        // Events are stamped with this core's cycle, not the global clock
+        // the serial loop left behind.
+        TRACE_SET_THREAD_CYCLE(totalCycles);
+        if (current.gap > 0)
+        {
+            uint64_t k = std::min<uint64_t>(current.gap, n - cycles);
+            skipCompute(k);
+            cycles += k;
+            continue;
+        }
+        int charged = chargeRun(static_cast<int>(std::min<uint64_t>(n - cycles, INT_MAX)));
+        if (charged > 0)
+        {
+            cycles += charged;
+            continue;
+        }
+        executeCycle();
+        cycles++;
+    }
+    TRACE_SET_THREAD_CYCLE(UINT64_MAX);
+}
+
+int Processor::runLength(int maxCycles) const
+{
+    // Once instructions were fetched ahead, the source's run describes the
+    // last of them rather than the current one.
+    uint32_t upcoming = lookahead.empty() ? source->runRemaining() : 0;
+    if (upcoming == 0)
+        return 0;
+    // Bit 0 is the current instruction, bit i the i-th one after it.
+    uint64_t writes = (current.op == OperationType::WRITE ? 1ULL : 0ULL) | (source->runWriteMask() << 1);
+    int k = std::min(static_cast<int>(upcoming) + 1, maxCycles);
+    // A write to a Shared block needs an upgrade, so the run stops before it.
+    if (writes != 0 && l1Cache->getBlockState(current.address) == MESIState::Shared)
+        k = std::min(k, __builtin_ctzll(writes));
+    return (k < 2) ? 0 : k;
+}
+
+int Processor::chargeRun(int maxCycles)
+{
+    int k = runLength(maxCycles);
+    if (k == 0)
+        return 0;
+
+    uint64_t writes = (current.op == OperationType::WRITE ? 1ULL : 0ULL) | (source->runWriteMask() << 1);
+    uint64_t mask = (k >= 64) ? ~0ULL : ((1ULL << k) - 1);
+    int numWrites = __builtin_popcountll(writes & mask);
+    l1Cache->chargeHits(current.address, numWrites > 0);
+    totalReadInstructions += k - numWrites;
+    totalWriteInstructions += numWrites;
+    totalCycles += k;
+    currentInstructionIndex += k;
+    source->skipRun(k - 1);
+    fetch();
+    translated = false;
+    return k;
+}
+
 bool Processor::isFinished() const
 {
-    return (currentInstructionIndex >= instructions.size() &&
-            !l1Cache->isTransactionPending());
+    return (!hasCurrent &&
+            !l1Cache->isTransactionPending() &&
+            storeBuffer.empty());
 }
 
-int Processor::getTotalCycles() const
+uint64_t Processor::getTotalCycles() const
 {
     return totalCycles;
 
 }
 
-int Processor::getIdleCycles() const
+uint64_t Processor::getIdleCycles() const
 {
     return idleCycles;
 }
@@ -0,0 +1,156 @@
+#include "Profiler.hpp"
+#include <iomanip>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+static const char *sectionName(int section)
+{
+    switch (static_cast<ProfileSection>(section))
+    {
+    case ProfileSection::TraceLoad:
+        return "Trace Loading";
+    case ProfileSection::MainLoop:
+        return "Main Loop";
+    case ProfileSection::BusResolve:
+        return "Bus::resolveTransactions";
+    case ProfileSection::ProcessorCycle:
+        return "Processor::executeCycle";
+    case ProfileSection::RunAhead:
+        return "Processor::runLocal (parallel phase)";
+    default:
+        return "Unknown";
+    }
+}
+
+Profiler::Profiler()
+    : countersAvailable(false)
+{
+    for (int i = 0; i < numSections; ++i)
+    {
+        elapsedNs[i] = 0;
+        calls[i] = 0;
+    }
+    for (int i = 0; i < numCounters; ++i)
+    {
+        counterFds[i] = -1;
+        counterValues[i] = 0;
+    }
+}
+
+Profiler::~Profiler()
+{
+#ifdef __linux__
+    for (int i = 0; i < numCounters; ++i)
+    {
+        if (counterFds[i] >= 0)
+            close(counterFds[i]);
+    }
+#endif
+}
+
+#ifdef __linux__
+// Opens one hardware counter for this thread; returns -1 if the kernel refuses.
+static int openCounter(uint64_t config, int groupFd)
+{
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = (groupFd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Count threads started later too (the --parallel core threads).
+    attr.inherit = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+
+void Profiler::startCounters()
+{
+#ifdef __linux__
+    const uint64_t configs[numCounters] = {
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_CACHE_MISSES};
+
+    counterFds[0] = openCounter(configs[0], -1);
+    if (counterFds[0] < 0)
+        return;
+    for (int i = 1; i < numCounters; ++i)
+        counterFds[i] = openCounter(configs[i], counterFds[0]);
+
+    ioctl(counterFds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counterFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    countersAvailable = true;
+#endif
+}
+
+void Profiler::stopCounters()
+{
+#ifdef __linux__
+    if (!countersAvailable)
+        return;
+    ioctl(counterFds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (int i = 0; i < numCounters; ++i)
+    {
+        uint64_t value = 0;
+        if (counterFds[i] >= 0 && read(counterFds[i], &value, sizeof(value)) == sizeof(value))
+            counterValues[i] = value;
+    }
+#endif
+}
+
+void Profiler::printReport(std::ostream &out, uint64_t simulatedCycles) const
+{
+    double loopSeconds = elapsedNs[static_cast<int>(ProfileSection::MainLoop)] / 1e9;
+
+    out << "\nHost Profile:\n";
+    for (int i = 0; i < numSections; ++i)
+    {
+        if (calls[i] == 0 && static_cast<ProfileSection>(i) == ProfileSection::RunAhead)
+            continue;
+        out << sectionName(i) << ": " << std::fixed << std::setprecision(3)
+            << elapsedNs[i] / 1e6 << " ms";
+        if (calls[i] > 1)
+            out << " (" << calls[i] << " calls, "
+                << std::setprecision(1) << static_cast<double>(elapsedNs[i]) / calls[i] << " ns/call)";
+        out << "\n";
+    }
+
+    double cyclesPerSecond = (loopSeconds > 0.0) ? simulatedCycles / loopSeconds : 0.0;
+    out << "Simulated Cycles: " << simulatedCycles << "\n";
+    out << "Simulated Cycles per Host Second: " << std::setprecision(0) << cyclesPerSecond << "\n";
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        long peakKB = usage.ru_maxrss / 1024; // Reported in bytes on macOS.
+#else
+        long peakKB = usage.ru_maxrss;        // Reported in kilobytes on Linux.
+#endif
+        out << "Peak RSS (KB): " << peakKB << "\n";
+    }
+
+    if (!countersAvailable)
+    {
+        out << "Hardware Counters: unavailable\n";
+        return;
+    }
+    uint64_t instructions = counterValues[0];
+    uint64_t cycles = counterValues[1];
+    uint64_t llcMisses = counterValues[2];
+    out << "Host Instructions: " << instructions << "\n";
+    out << "Host Cycles: " << cycles << "\n";
+    out << "Host IPC: " << std::setprecision(2)
+        << ((cycles > 0) ? static_cast<double>(instructions) / cycles : 0.0) << "\n";
+    out << "Host LLC Misses: " << llcMisses << "\n";
+}
@@ -0,0 +1,191 @@
+#include "ResultCache.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bumped whenever the entry layout changes.
+static const char *ENTRY_MAGIC = "l1sim-result 1\n";
+// Files are hashed in chunks of this size, each seeded by the last.
+static const size_t HASH_CHUNK_BYTES = 1 << 20;
+
+static inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Murmur3's 64-bit finaliser.
+static inline uint64_t fmix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    uint64_t h = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+    while (size >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h ^= rotl(word * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+        h = rotl(h, 27) * 5 + 0x52dce729;
+        p += 8;
+        size -= 8;
+    }
+    uint64_t tail = 0;
+    for (size_t i = 0; i < size; ++i)
+        tail |= static_cast<uint64_t>(p[i]) << (8 * i);
+    h ^= rotl(tail * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+    return fmix(h);
+}
+
+bool hashFile(const std::string &path, uint64_t &hash)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::vector<char> buffer(HASH_CHUNK_BYTES);
+    hash = 0;
+    while (in)
+    {
+        in.read(buffer.data(), buffer.size());
+        hash = hashBytes(buffer.data(), static_cast<size_t>(in.gcount()), hash);
+    }
+    return in.eof();
+}
+
+static std::string toHex(uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+//------------------------------------------------------------------
+void ResultKey::addValue(const std::string &name, const std::string &value)
+{
+    material += name + " " + value + "\n";
+}
+
+bool ResultKey::addFile(const std::string &name, const std::string &path)
+{
+    uint64_t hash;
+    if (!hashFile(path, hash))
+    {
+        addValue(name, "missing");
+        return false;
+    }
+    addValue(name, toHex(hash));
+    return true;
+}
+
+std::string ResultKey::digest() const
+{
+    return toHex(hashBytes(material.data(), material.size()));
+}
+
+//------------------------------------------------------------------
+ResultCache::ResultCache(const std::string &directory)
+    : directory(directory)
+{
+}
+
+std::string ResultCache::entryPath(const ResultKey &key) const
+{
+    return directory + "/" + key.digest() + ".txt";
+}
+
+bool ResultCache::lookup(const ResultKey &key, std::string &output) const
+{
+    std::ifstream in(entryPath(key), std::ios::binary);
+    if (!in)
+        return false;
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    std::string entry = contents.str();
+
+    // Layout: magic, key text, "output <bytes>", then exactly that many bytes.
+    std::string header = std::string(ENTRY_MAGIC) + key.text() + "output ";
+    if (entry.compare(0, header.size(), header) != 0)
+        return false;
+    size_t newline = entry.find('\n', header.size());
+    if (newline == std::string::npos)
+        return false;
+    unsigned long long bytes = std::strtoull(entry.c_str() + header.size(), nullptr, 10);
+    if (entry.size() - (newline + 1) != bytes)
+        return false; // Truncated or edited by hand.
+    output = entry.substr(newline + 1);
+    return true;
+}
+
+bool ResultCache::store(const ResultKey &key, const std::string &output) const
+{
+    if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Cannot create result cache " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Write beside the entry and rename over it, so concurrent sweeps never
+    // read a half-written result.
+    std::string path = entryPath(key);
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << ENTRY_MAGIC << key.text() << "output " << output.size() << "\n" << output;
+        if (!out)
+        {
+            std::cerr << "Cannot write result cache entry " << temporary << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Cannot write result cache entry " << path << ": " << std::strerror(errno) << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+OutputRecorder::OutputRecorder(std::ostream &stream)
+    : stream(stream),
+      target(stream.rdbuf(this))
+{
+}
+
+OutputRecorder::~OutputRecorder()
+{
+    stream.rdbuf(target);
+}
+
+int OutputRecorder::overflow(int c)
+{
+    if (c == traits_type::eof())
+        return traits_type::not_eof(c);
+    text.push_back(static_cast<char>(c));
+    return target->sputc(static_cast<char>(c));
+}
+
+std::streamsize OutputRecorder::xsputn(const char *s, std::streamsize n)
+{
+    text.append(s, static_cast<size_t>(n));
+    return target->sputn(s, n);
+}
+
+int OutputRecorder::sync()
+{
+    return target->pubsync();
+}
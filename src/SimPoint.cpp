@@ -0,0 +1,302 @@
+#include "SimPoint.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+typedef std::vector<std::vector<double>> Points;
+
+// splitmix64 finaliser.
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Entry (key, d) of the random projection matrix, uniform in [-1, 1).
+// Derived from a hash so the matrix never has to be stored.
+static double projection(uint64_t key, int d, uint64_t seed)
+{
+    return (mix(key ^ mix(seed * 64 + d)) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+std::vector<std::vector<double>> intervalSignatures(const std::vector<std::vector<Instruction>> &traces,
+                                                    const SimPointConfig &config)
+{
+    size_t longest = 0;
+    for (const auto &trace : traces)
+        longest = std::max(longest, trace.size());
+    uint64_t length = config.intervalLength;
+    size_t numIntervals = (longest + length - 1) / length;
+
+    Points signatures(numIntervals, std::vector<double>(config.dimensions, 0.0));
+    std::unordered_map<uint64_t, uint32_t> counts;
+    for (size_t i = 0; i < numIntervals; ++i)
+    {
+        counts.clear();
+        uint64_t accesses = 0;
+        for (size_t core = 0; core < traces.size(); ++core)
+        {
+            size_t end = std::min<size_t>((i + 1) * length, traces[core].size());
+            for (size_t j = i * length; j < end; ++j)
+            {
+                if (traces[core][j].op == OperationType::FENCE)
+                    continue;
+                counts[(static_cast<uint64_t>(core) << 32) | (traces[core][j].address >> config.blockBits)]++;
+                accesses++;
+            }
+        }
+        for (const auto &entry : counts)
+        {
+            double frequency = static_cast<double>(entry.second) / accesses;
+            for (int d = 0; d < config.dimensions; ++d)
+                signatures[i][d] += frequency * projection(entry.first, d, config.seed);
+        }
+    }
+    return signatures;
+}
+
+//------------------------------------------------------------------
+static double distance2(const std::vector<double> &a, const std::vector<double> &b)
+{
+    double sum = 0.0;
+    for (size_t d = 0; d < a.size(); ++d)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+
+struct Clustering
+{
+    std::vector<int> assignment;
+    Points centres;
+    double error = 0.0; // Sum of squared distances to the assigned centres.
+};
+
+// k-means++ seeding followed by Lloyd iterations.
+static Clustering kmeans(const Points &points, int k, std::mt19937_64 &rng)
+{
+    size_t n = points.size();
+    Clustering c;
+    c.centres.push_back(points[std::uniform_int_distribution<size_t>(0, n - 1)(rng)]);
+    std::vector<double> nearest(n, std::numeric_limits<double>::max());
+    while (static_cast<int>(c.centres.size()) < k)
+    {
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            nearest[i] = std::min(nearest[i], distance2(points[i], c.centres.back()));
+            total += nearest[i];
+        }
+        if (total == 0.0)
+            break; // Fewer distinct points than k.
+        double r = std::uniform_real_distribution<double>(0.0, total)(rng);
+        size_t pick = 0;
+        while (pick + 1 < n && (r -= nearest[pick]) > 0.0)
+            pick++;
+        c.centres.push_back(points[pick]);
+    }
+
+    c.assignment.assign(n, -1);
+    for (int iteration = 0; iteration < 100; ++iteration)
+    {
+        bool changed = false;
+        for (size_t i = 0; i < n; ++i)
+        {
+            int best = 0;
+            for (size_t j = 1; j < c.centres.size(); ++j)
+            {
+                if (distance2(points[i], c.centres[j]) < distance2(points[i], c.centres[best]))
+                    best = static_cast<int>(j);
+            }
+            if (best != c.assignment[i])
+            {
+                c.assignment[i] = best;
+                changed = true;
+            }
+        }
+        if (!changed)
+            break;
+        // Empty clusters keep their previous centre.
+        Points sums(c.centres.size(), std::vector<double>(points[0].size(), 0.0));
+        std::vector<size_t> sizes(c.centres.size(), 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t d = 0; d < points[i].size(); ++d)
+                sums[c.assignment[i]][d] += points[i][d];
+            sizes[c.assignment[i]]++;
+        }
+        for (size_t j = 0; j < c.centres.size(); ++j)
+        {
+            for (size_t d = 0; sizes[j] > 0 && d < sums[j].size(); ++d)
+                c.centres[j][d] = sums[j][d] / sizes[j];
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        c.error += distance2(points[i], c.centres[c.assignment[i]]);
+    return c;
+}
+
+// Bayesian information criterion of a clustering under a spherical
+// Gaussian model with one shared variance (as in X-means and SimPoint).
+static double bicScore(const Points &points, const Clustering &c)
+{
+    double R = static_cast<double>(points.size());
+    double M = static_cast<double>(points[0].size());
+    double K = static_cast<double>(c.centres.size());
+    if (R <= K)
+        return -std::numeric_limits<double>::max();
+    double variance = std::max(c.error / (M * (R - K)), 1e-12);
+
+    std::vector<double> sizes(c.centres.size(), 0.0);
+    for (int a : c.assignment)
+        sizes[a] += 1.0;
+    double logLikelihood = -R * M / 2.0 * std::log(2.0 * M_PI * variance) - M * (R - K) / 2.0;
+    for (double size : sizes)
+    {
+        if (size > 0.0)
+            logLikelihood += size * std::log(size / R);
+    }
+    double parameters = (K - 1.0) + K * M + 1.0;
+    return logLikelihood - parameters / 2.0 * std::log(R);
+}
+
+SimPointSet pickSimPoints(const std::vector<std::vector<double>> &signatures, const SimPointConfig &config)
+{
+    SimPointSet set;
+    set.intervalLength = config.intervalLength;
+    set.numIntervals = signatures.size();
+    if (signatures.empty())
+        return set;
+
+    std::mt19937_64 rng(config.seed);
+    int maxK = std::min<int>(config.maxClusters, static_cast<int>(signatures.size()));
+    std::vector<Clustering> best(maxK + 1);
+    std::vector<double> scores(maxK + 1);
+    for (int k = 1; k <= maxK; ++k)
+    {
+        for (int run = 0; run < config.restarts; ++run)
+        {
+            Clustering c = kmeans(signatures, k, rng);
+            if (run == 0 || c.error < best[k].error)
+                best[k] = c;
+        }
+        scores[k] = bicScore(signatures, best[k]);
+    }
+    double low = *std::min_element(scores.begin() + 1, scores.end());
+    double high = *std::max_element(scores.begin() + 1, scores.end());
+    int chosen = 1;
+    while (chosen < maxK && scores[chosen] < low + 0.9 * (high - low))
+        chosen++;
+
+    const Clustering &c = best[chosen];
+    for (size_t j = 0; j < c.centres.size(); ++j)
+    {
+        size_t members = 0, representative = 0;
+        double closest = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < signatures.size(); ++i)
+        {
+            if (c.assignment[i] != static_cast<int>(j))
+                continue;
+            members++;
+            double d = distance2(signatures[i], c.centres[j]);
+            if (d < closest)
+            {
+                closest = d;
+                representative = i;
+            }
+        }
+        if (members > 0)
+            set.points.push_back({representative, static_cast<double>(members) / signatures.size()});
+    }
+    std::sort(set.points.begin(), set.points.end(),
+              [](const SimPoint &a, const SimPoint &b) { return a.interval < b.interval; });
+    return set;
+}
+
+//------------------------------------------------------------------
+bool writeSimPoints(const std::string &path, const SimPointSet &set)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+    out << "# L1simulate SimPoints: <interval> <weight>\n";
+    out << "interval-length " << set.intervalLength << "\n";
+    out << "intervals " << set.numIntervals << "\n";
+    for (const SimPoint &p : set.points)
+        out << p.interval << " " << p.weight << "\n";
+    return true;
+}
+
+bool readSimPoints(const std::string &path, SimPointSet &set)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::cerr << "Cannot open SimPoint file " << path << std::endl;
+        return false;
+    }
+    set = SimPointSet();
+    std::string line;
+    double totalWeight = 0.0;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        std::string first;
+        fields >> first;
+        if (first == "interval-length")
+            fields >> set.intervalLength;
+        else if (first == "intervals")
+            fields >> set.numIntervals;
+        else
+        {
+            SimPoint p;
+            try
+            {
+                p.interval = std::stoull(first);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Malformed line in " << path << ": " << line << std::endl;
+                return false;
+            }
+            if (!(fields >> p.weight) || p.weight <= 0.0)
+            {
+                std::cerr << "Malformed line in " << path << ": " << line << std::endl;
+                return false;
+            }
+            set.points.push_back(p);
+            totalWeight += p.weight;
+        }
+    }
+    if (set.intervalLength == 0 || set.points.empty())
+    {
+        std::cerr << path << " has no interval length or no points" << std::endl;
+        return false;
+    }
+    for (const SimPoint &p : set.points)
+    {
+        if (p.interval >= set.numIntervals)
+        {
+            std::cerr << "Interval " << p.interval << " in " << path << " is out of range" << std::endl;
+            return false;
+        }
+    }
+    if (std::fabs(totalWeight - 1.0) > 0.01)
+    {
+        std::cerr << "Weights in " << path << " sum to " << totalWeight << ", not 1" << std::endl;
+        return false;
+    }
+    return true;
+}
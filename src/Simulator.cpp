@@ -0,0 +1,399 @@
+#include "Simulator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include "EventTrace.hpp"
+
+bool checkSimulationConfig(const SimulationConfig &config)
+{
+    if (config.predecode && config.storeBufferEntries > 0) {
+        std::cerr << "--predecode drops word offsets, which store buffer forwarding needs" << std::endl;
+        return false;
+    }
+    if (config.useTlb && (config.predecode || config.storeBufferEntries > 0)) {
+        std::cerr << "--tlb cannot be combined with --predecode or --store-buffer" << std::endl;
+        return false;
+    }
+    if (config.useTlb && config.tlb.pageBits < config.b) {
+        std::cerr << "TLB page size must be at least the block size" << std::endl;
+        return false;
+    }
+    if (config.useDirectory &&
+        (config.useL2 || config.useDram || config.writebackBufferEntries > 0 ||
+         config.reportBusWait || config.prefetcher != PrefetcherKind::None)) {
+        std::cerr << "--directory cannot be combined with --l2, --dram, --writeback-buffer, --arbitration or --prefetch" << std::endl;
+        return false;
+    }
+    if (config.useClusters &&
+        (config.useDirectory || config.writebackBufferEntries > 0 || config.prefetcher != PrefetcherKind::None)) {
+        std::cerr << "--clusters cannot be combined with --directory, --writeback-buffer or --prefetch" << std::endl;
+        return false;
+    }
+    if (config.useClusters &&
+        (config.cluster.clusters > config.numCores || config.numCores % config.cluster.clusters != 0)) {
+        std::cerr << "The cluster count must divide the core count (" << config.numCores << ")" << std::endl;
+        return false;
+    }
+    if (!config.simpointFile.empty() &&
+        (config.useWorkload || config.predecode || !config.quantumSweep.empty() ||
+         config.snapshotInterval > 0 || !config.eventTraceFile.empty())) {
+        std::cerr << "--simpoints cannot be combined with -w, --predecode, --quantum-sweep, --snapshot-interval or --event-trace" << std::endl;
+        return false;
+    }
+    if (!config.eventTraceFile.empty() && EVENT_TRACE_CATEGORIES == 0) {
+        std::cerr << "--event-trace needs a build with trace points (make debug)" << std::endl;
+        return false;
+    }
+    if (config.estimate &&
+        (config.predecode || config.parallelQuantum > 0 || !config.quantumSweep.empty() ||
+         config.prefetcher != PrefetcherKind::None || config.storeBufferEntries > 0 || config.victimEntries > 0 ||
+         config.useL2 || config.useDram || config.writebackBufferEntries > 0 || config.reportBusWait ||
+         config.useDirectory || config.useClusters || config.useTlb || config.snapshotInterval > 0 ||
+         !config.simpointFile.empty() || !config.eventTraceFile.empty())) {
+        std::cerr << "--estimate models the base system only: it takes -t or -w, -s, -E, -b and --cores" << std::endl;
+        return false;
+    }
+    if (config.useL2 && config.l2b < config.b) {
+        std::cerr << "L2 block size must be at least the L1 block size" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Simulator::Simulator(const SimulationConfig &config, Profiler *profiler)
+    : Simulator(config, std::vector<InstructionSource*>(), profiler)
+{
+}
+
+Simulator::Simulator(const SimulationConfig &config, const std::vector<InstructionSource*> &sources,
+                     Profiler *profiler)
+    : numCores(config.numCores),
+      prof(profiler)
+{
+    // Create a separate cache and processor for each core.
+    // IMPORTANT: When constructing caches, pass the processor's id.
+    auto loadStart = std::chrono::steady_clock::now();
+    if (config.useDirectory) {
+        directory = new Directory(config.directory, numCores, 1 << config.b);
+        bus.reset(directory);
+    } else if (config.useClusters) {
+        clustered = new ClusteredBus(config.cluster, numCores);
+        bus.reset(clustered);
+    } else {
+        bus.reset(new Bus());
+    }
+    if (config.useL2) {
+        l2.reset(new L2Cache(config.l2s, config.l2E, config.l2b, config.l2Latency, config.l2Inclusive));
+        bus->setL2(l2.get());
+    }
+    bus->setArbitration(config.arbitration, numCores);
+    bus->setWritebackBufferSize(config.writebackBufferEntries);
+    if (config.useDram) {
+        dram.reset(new Dram(config.dram));
+        bus->setDram(dram.get());
+    }
+    if (config.useTlb) {
+        // Frame bits that also select an L1 set are the page's color.
+        pageMapper.reset(PageMapper::create(config.tlb, std::max(0, config.s + config.b - config.tlb.pageBits)));
+    }
+    for (int i = 0; i < numCores; ++i) {
+        Bus *coreBus = clustered ? clustered->getClusterBus(i) : bus.get();
+        Cache* cache = Cache::create(config.s, config.E, config.b, i, coreBus, config.genericCache);
+        cache->setPrefetcher(Prefetcher::create(config.prefetcher, config.prefetchDegree));
+        cache->setVictimCacheSize(config.victimEntries);
+        caches.push_back(cache);
+        Processor* proc;
+        if (!sources.empty()) {
+            proc = new Processor(i, sources[i], cache, coreBus);
+        } else if (config.useWorkload) {
+            proc = new Processor(i, new SyntheticSource(config.workload, i), cache, coreBus);
+        } else {
+            // Construct trace file name (e.g., "app1_proc0.trace").
+            std::string traceFile = config.tracePrefix + "_proc" + std::to_string(i) + ".trace";
+            if (config.predecode) {
+                proc = new Processor(i, new DecodedTraceSource(traceFile, config.b), cache, coreBus);
+            } else {
+                proc = new Processor(i, traceFile, cache, coreBus);
+            }
+        }
+        proc->setStoreBufferSize(config.storeBufferEntries);
+        if (pageMapper) {
+            tlbs.emplace_back(new Tlb(config.tlb, pageMapper.get()));
+            proc->setTlb(tlbs.back().get());
+        }
+        processors.push_back(proc);
+    }
+    if (prof) {
+        prof->add(ProfileSection::TraceLoad,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - loadStart).count());
+    }
+}
+
+Simulator::~Simulator()
+{
+    // Clean up.
+    for (auto proc : processors) {
+        delete proc;
+    }
+    for (auto cache : caches) {
+        delete cache;
+    }
+}
+
+void Simulator::setSnapshots(SnapshotWriter *writer, uint64_t interval)
+{
+    snapshots = writer;
+    snapshotInterval = interval;
+    nextSnapshot = (writer && interval > 0) ? interval : UINT64_MAX;
+}
+
+void Simulator::setSources(const std::vector<InstructionSource*> &sources)
+{
+    for (int i = 0; i < numCores; ++i) {
+        processors[i]->setSource(sources[i]);
+    }
+}
+
+void Simulator::takeSnapshot()
+{
+    snapshots->write(globalClock, processors, caches, *bus);
+    nextSnapshot += snapshotInterval;
+}
+
+void Simulator::run()
+{
+    auto loopStart = std::chrono::steady_clock::now();
+    if (prof) {
+        prof->startCounters();
+    }
+
+    // Global clock simulation loop.
+    while (!tick()) {
+        skipLocalWork(UINT64_MAX);
+    }
+    if (snapshots) {
+        snapshots->write(globalClock, processors, caches, *bus);
+    }
+    if (prof) {
+        prof->stopCounters();
+        prof->add(ProfileSection::MainLoop,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - loopStart).count());
+    }
+}
+
+bool Simulator::tick()
+{
+    TRACE_SET_CYCLE(globalClock);
+    bool allFinished = true;
+    // Resolve any bus transactions at the end of the cycle.
+    if (prof) {
+        ProfileScope scope(*prof, ProfileSection::BusResolve);
+        bus->resolveTransactions(caches);
+    } else {
+        bus->resolveTransactions(caches);
+    }
+    for (int i = 0; i < numCores; ++i) {
+        if (!processors[i]->isFinished() || bus->hasPendingtransaction()) {
+            if (prof) {
+                ProfileScope scope(*prof, ProfileSection::ProcessorCycle);
+                processors[i]->executeCycle();
+            } else {
+                processors[i]->executeCycle();
+            }
+            allFinished = false;
+        }
+    }
+
+    globalClock++;
+    if (globalClock == nextSnapshot) {
+        takeSnapshot();
+    }
+    return allFinished;
+}
+
+uint64_t Simulator::skipLocalWork(uint64_t limit)
+{
+    if (!bus->isIdle()) {
+        return 0;
+    }
+    uint64_t skip = std::min(limit, nextSnapshot - globalClock);
+    bool anyRunning = false;
+    for (const Processor *proc : processors) {
+        if (proc->isFinished()) {
+            continue;
+        }
+        skip = std::min(skip, proc->getLocalCyclesAhead());
+        anyRunning = true;
+    }
+    if (!anyRunning || skip == 0) {
+        return 0;
+    }
+
+    // Exactly what `skip` ticks would do: nothing reaches the bus, and
+    // every running core counts down its gap or hits in its own L1.
+    for (Processor *proc : processors) {
+        if (!proc->isFinished()) {
+            proc->skipLocal(skip);
+        }
+    }
+    bus->skipIdleCycles(skip);
+    globalClock += skip;
+    if (globalClock == nextSnapshot) {
+        takeSnapshot();
+    }
+    return skip;
+}
+
+bool Simulator::step(uint64_t cycles)
+{
+    for (uint64_t n = 0; n < cycles; ++n) {
+        if (isFinished()) {
+            return true;
+        }
+        tick();
+        n += skipLocalWork(cycles - n - 1);
+    }
+    return isFinished();
+}
+
+bool Simulator::isFinished() const
+{
+    if (bus->hasPendingtransaction()) {
+        return false;
+    }
+    for (const Processor *proc : processors) {
+        if (!proc->isFinished()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Simulator::resume()
+{
+    for (Processor *proc : processors) {
+        proc->resume();
+    }
+}
+
+void Simulator::runParallel(int quantum)
+{
+    auto loopStart = std::chrono::steady_clock::now();
+    if (prof) {
+        // Before the core threads start, so that they are counted too.
+        prof->startCounters();
+    }
+
+    // The serial loop, except that wherever skipLocalWork would jump the
+    // clock the cores run the window on their own threads. A window opens
+    // only while the bus is idle and ends before the first cycle any core
+    // needs it, so no core runs into a cycle the bus has not resolved yet
+    // and results are identical to run().
+    //
+    // Each core's thread waits for a new epoch, publishes how far it could
+    // go alone, waits until every core has, and then runs the common span.
+    // Synchronisation is lock-free: each thread only writes its own slot of
+    // `horizon` and its own Processor/Cache, and the main thread only
+    // touches shared state while every core thread is parked.
+    std::vector<uint64_t> horizon(numCores, 0);
+    uint64_t limit = 0;
+    std::atomic<uint64_t> epoch(0);
+    std::atomic<int> scanned(0);
+    std::atomic<int> arrived(0);
+    std::atomic<bool> stop(false);
+
+    // Spinning only pays off when every thread has its own host CPU.
+    const int spinLimit = (std::thread::hardware_concurrency() > static_cast<unsigned>(numCores)) ? 1000 : 0;
+    auto waitFor = [spinLimit](const std::function<bool()> &ready) {
+        int spins = 0;
+        while (!ready()) {
+            if (++spins > spinLimit) {
+                std::this_thread::yield();
+            }
+        }
+    };
+    auto commonSpan = [&]() {
+        return *std::min_element(horizon.begin(), horizon.end());
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numCores; ++i) {
+        threads.emplace_back([&, i]() {
+            uint64_t seen = 0;
+            while (true) {
+                waitFor([&]() { return epoch.load(std::memory_order_acquire) != seen; });
+                seen = epoch.load(std::memory_order_acquire);
+                if (stop.load(std::memory_order_acquire))
+                    return;
+                bool finished = processors[i]->isFinished();
+                horizon[i] = finished ? UINT64_MAX : processors[i]->localHorizon(limit);
+                scanned.fetch_add(1, std::memory_order_acq_rel);
+                waitFor([&]() { return scanned.load(std::memory_order_acquire) == numCores; });
+                if (!finished) {
+                    processors[i]->runLocal(commonSpan());
+                }
+                arrived.fetch_add(1, std::memory_order_acq_rel);
+            }
+        });
+    }
+
+    while (!tick()) {
+        if (!bus->isIdle()) {
+            continue;
+        }
+        // A one-cycle look is cheap and rules out most windows before the
+        // threads are woken.
+        bool anyRunning = false;
+        bool open = true;
+        for (Processor *proc : processors) {
+            if (proc->isFinished()) {
+                continue;
+            }
+            anyRunning = true;
+            if (proc->localHorizon(1) == 0) {
+                open = false;
+                break;
+            }
+        }
+        if (!anyRunning || !open) {
+            continue;
+        }
+
+        auto phaseStart = std::chrono::steady_clock::now();
+        limit = std::min<uint64_t>(static_cast<uint64_t>(quantum), nextSnapshot - globalClock);
+        scanned.store(0, std::memory_order_release);
+        arrived.store(0, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_acq_rel);
+        waitFor([&]() { return arrived.load(std::memory_order_acquire) == numCores; });
+        if (prof) {
+            prof->add(ProfileSection::RunAhead,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - phaseStart).count());
+        }
+
+        // Exactly what skipLocalWork does with the clock and the bus.
+        uint64_t span = commonSpan();
+        bus->skipIdleCycles(span);
+        globalClock += span;
+        if (globalClock == nextSnapshot) {
+            takeSnapshot();
+        }
+    }
+    if (snapshots) {
+        snapshots->write(globalClock, processors, caches, *bus);
+    }
+
+    stop.store(true, std::memory_order_release);
+    epoch.fetch_add(1, std::memory_order_acq_rel);
+    for (auto &t : threads) {
+        t.join();
+    }
+    if (prof) {
+        // After the join: inherited thread counts are folded in on exit.
+        prof->stopCounters();
+        prof->add(ProfileSection::MainLoop,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - loopStart).count());
+    }
+}
@@ -0,0 +1,46 @@
+#include "Snapshot.hpp"
+#include "Bus.hpp"
+#include "Cache.hpp"
+#include "Processor.hpp"
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+SnapshotWriter::SnapshotWriter(const std::string &path)
+    : out(path, std::ios::app), json(endsWith(path, ".json") || endsWith(path, ".jsonl"))
+{
+    if (out.is_open() && !json && out.tellp() == 0)
+        out << "cycle,core,instructions,misses,idle_cycles,bus_queue_depth\n";
+}
+
+void SnapshotWriter::write(uint64_t clock, const std::vector<Processor *> &processors,
+                           const std::vector<Cache *> &caches, const Bus &bus)
+{
+    size_t depth = bus.getQueueDepth();
+    if (json)
+    {
+        out << "{\"cycle\":" << clock << ",\"bus_queue_depth\":" << depth << ",\"cores\":[";
+        for (size_t i = 0; i < processors.size(); ++i)
+        {
+            out << (i ? "," : "") << "{\"core\":" << i
+                << ",\"instructions\":" << processors[i]->getInstructionsExecuted()
+                << ",\"misses\":" << caches[i]->getCacheMisses()
+                << ",\"idle_cycles\":" << processors[i]->getIdleCycles() << "}";
+        }
+        out << "]}\n";
+    }
+    else
+    {
+        for (size_t i = 0; i < processors.size(); ++i)
+        {
+            out << clock << "," << i << ","
+                << processors[i]->getInstructionsExecuted() << ","
+                << caches[i]->getCacheMisses() << ","
+                << processors[i]->getIdleCycles() << ","
+                << depth << "\n";
+        }
+    }
+    out.flush();
+}
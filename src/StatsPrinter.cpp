@@ -45,18 +45,18 @@ void printSimulationParameters(const SimulationConfig &config, int numSets, int
 void printCoreStats(const std::vector<Processor*> &processors, const std::vector<Cache*> &caches) {
     for (size_t i = 0; i < processors.size(); ++i) {
         // These functions should be implemented in your Processor and Cache classes.
-        int totalInstr = processors[i]->getTotalInstructions();
-        int totalReads = processors[i]->getTotalReads();
-        int totalWrites = processors[i]->getTotalWrites();
-        int totalCycles = processors[i]->getTotalCycles();
-        int idleCycles = processors[i]->getIdleCycles();
-        int misses = caches[i]->getCacheMisses();
-        int accesses = totalReads + totalWrites;
+        uint64_t totalInstr = processors[i]->getTotalInstructions();
+        uint64_t totalReads = processors[i]->getTotalReads();
+        uint64_t totalWrites = processors[i]->getTotalWrites();
+        uint64_t totalCycles = processors[i]->getTotalCycles();
+        uint64_t idleCycles = processors[i]->getIdleCycles();
+        uint64_t misses = caches[i]->getCacheMisses();
+        uint64_t accesses = totalReads + totalWrites;
         double missRate = (accesses > 0) ? (100.0 * misses / accesses) : 0.0;
-        int evictions = caches[i]->getEvictions();
-        int writebacks = caches[i]->getWritebacks();
-        int busInvalidations = caches[i]->getBusInvalidations();
-        int dataTraffic = caches[i]->getDataTrafficBytes();
+        uint64_t evictions = caches[i]->getEvictions();
+        uint64_t writebacks = caches[i]->getWritebacks();
+        uint64_t busInvalidations = caches[i]->getBusInvalidations();
+        uint64_t dataTraffic = caches[i]->getDataTrafficBytes();
         
         std::cout << "Core " << i << " Statistics:\n";
         std::cout << "Total Instructions: " << totalInstr << "\n";
@@ -76,8 +76,8 @@ void printCoreStats(const std::vector<Processor*> &processors, const std::vector
 // Function to print overall bus summary.
 // We assume the Bus class provides getTotalBusTransactions() and getBusTrafficBytes().
 void printBusSummary(Bus *bus) {
-    int totalBusTx = bus->getTotalBusTransactions();
-    int totalTraffic = bus->getBusTrafficBytes();
+    uint64_t totalBusTx = bus->getTotalBusTransactions();
+    uint64_t totalTraffic = bus->getBusTrafficBytes();
     
     std::cout << "Overall Bus Summary:\n";
     std::cout << "Total Bus Transactions: " << totalBusTx << "\n";
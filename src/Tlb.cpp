@@ -0,0 +1,241 @@
+#include "Tlb.hpp"
+#include <iostream>
+#include <sstream>
+
+bool parseTlbSpec(const std::string &spec, TlbConfig &config)
+{
+    std::string mapping = spec.substr(0, spec.find(':'));
+    if (mapping == "identity")
+        config.mapping = PageMapping::Identity;
+    else if (mapping == "random")
+        config.mapping = PageMapping::Random;
+    else if (mapping == "color")
+        config.mapping = PageMapping::Coloring;
+    else
+    {
+        std::cerr << "Unknown page mapping '" << mapping << "' (expected identity, random or color)" << std::endl;
+        return false;
+    }
+
+    if (spec.find(':') != std::string::npos)
+    {
+        std::istringstream knobs(spec.substr(spec.find(':') + 1));
+        std::string knob;
+        while (std::getline(knobs, knob, ','))
+        {
+            size_t eq = knob.find('=');
+            if (eq == std::string::npos)
+            {
+                std::cerr << "Malformed TLB knob '" << knob << "' (expected key=value)" << std::endl;
+                return false;
+            }
+            std::string key = knob.substr(0, eq);
+            long long value;
+            try
+            {
+                value = std::stoll(knob.substr(eq + 1), nullptr, 0);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Invalid value for TLB knob '" << key << "': " << knob.substr(eq + 1) << std::endl;
+                return false;
+            }
+            if (key == "entries")
+                config.entries = static_cast<int>(value);
+            else if (key == "ways")
+                config.ways = static_cast<int>(value);
+            else if (key == "page")
+            {
+                // Page size in bytes; must be a power of two.
+                config.pageBits = 0;
+                while ((1LL << config.pageBits) < value)
+                    config.pageBits++;
+                if ((1LL << config.pageBits) != value)
+                {
+                    std::cerr << "TLB page size must be a power of two" << std::endl;
+                    return false;
+                }
+            }
+            else if (key == "levels")
+                config.levels = static_cast<int>(value);
+            else if (key == "penalty")
+                config.missPenalty = static_cast<int>(value);
+            else if (key == "seed")
+                config.seed = static_cast<uint64_t>(value);
+            else
+            {
+                std::cerr << "Unknown TLB knob '" << key << "'" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    if (config.entries < 1 || config.ways < 1 || config.entries % config.ways != 0 ||
+        config.pageBits < 8 || config.pageBits > 20 || config.levels < 1 || config.levels > 4 ||
+        config.missPenalty < 0)
+    {
+        std::cerr << "TLB entries must be a positive multiple of ways, pages 256 B to 1 MB, "
+                  << "levels 1 to 4 and the penalty non-negative" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char *pageMappingName(PageMapping mapping)
+{
+    switch (mapping)
+    {
+    case PageMapping::Identity:
+        return "identity";
+    case PageMapping::Random:
+        return "random";
+    case PageMapping::Coloring:
+        return "color";
+    default:
+        return "unknown";
+    }
+}
+
+//------------------------------------------------------------------
+PageMapper *PageMapper::create(const TlbConfig &config, int colorBits)
+{
+    switch (config.mapping)
+    {
+    case PageMapping::Random:
+        return new RandomMapper(config.pageBits, config.seed);
+    case PageMapping::Coloring:
+        return new ColoringMapper(config.pageBits, colorBits);
+    default:
+        return new IdentityMapper();
+    }
+}
+
+uint32_t IdentityMapper::frameOf(uint32_t page)
+{
+    frames.emplace(page, page);
+    return page;
+}
+
+RandomMapper::RandomMapper(int pageBits, uint64_t seed)
+    : numFrames(PAGE_TABLE_BASE >> pageBits),
+      rng(seed)
+{
+}
+
+uint32_t RandomMapper::frameOf(uint32_t page)
+{
+    auto it = frames.find(page);
+    if (it != frames.end())
+        return it->second;
+    uint32_t frame;
+    do
+    {
+        frame = static_cast<uint32_t>(rng() % numFrames);
+    } while (!used.insert(frame).second);
+    frames.emplace(page, frame);
+    return frame;
+}
+
+ColoringMapper::ColoringMapper(int pageBits, int colorBits)
+    : colorBits(colorBits),
+      framesPerColor((PAGE_TABLE_BASE >> pageBits) >> colorBits),
+      nextFrame(1u << colorBits, 0)
+{
+}
+
+uint32_t ColoringMapper::frameOf(uint32_t page)
+{
+    auto it = frames.find(page);
+    if (it != frames.end())
+        return it->second;
+    uint32_t color = page & ((1u << colorBits) - 1);
+    uint32_t frame = ((nextFrame[color]++ % framesPerColor) << colorBits) | color;
+    frames.emplace(page, frame);
+    return frame;
+}
+
+//------------------------------------------------------------------
+Tlb::Tlb(const TlbConfig &config, PageMapper *mapper)
+    : config(config),
+      mapper(mapper),
+      numSets(config.entries / config.ways),
+      entries(config.entries, Entry{false, 0, 0, 0})
+{
+    // Split the VPN bits over the levels, the root taking any remainder.
+    int vpnBits = 32 - config.pageBits;
+    for (int level = 0; level < config.levels; ++level)
+        levelBits.push_back(vpnBits / config.levels + (level < vpnBits % config.levels ? 1 : 0));
+    // Each level's tables are laid out back to back: the entry for a VPN
+    // prefix p of that level sits at levelBase + 4 * p.
+    uint32_t base = PAGE_TABLE_BASE;
+    int prefixBits = 0;
+    for (int level = 0; level < config.levels; ++level)
+    {
+        levelBase.push_back(base);
+        prefixBits += levelBits[level];
+        base += 4u << prefixBits;
+    }
+}
+
+bool Tlb::contains(uint32_t vaddr, uint32_t &paddr) const
+{
+    uint32_t page = vaddr >> config.pageBits;
+    const Entry *set = &entries[(page % numSets) * config.ways];
+    for (int way = 0; way < config.ways; ++way)
+    {
+        if (set[way].valid && set[way].page == page)
+        {
+            paddr = (set[way].frame << config.pageBits) | (vaddr & ((1u << config.pageBits) - 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Tlb::lookup(uint32_t vaddr, uint32_t &paddr)
+{
+    lookups++;
+    uint32_t page = vaddr >> config.pageBits;
+    Entry *set = &entries[(page % numSets) * config.ways];
+    for (int way = 0; way < config.ways; ++way)
+    {
+        if (set[way].valid && set[way].page == page)
+        {
+            set[way].lastUse = ++useClock;
+            paddr = (set[way].frame << config.pageBits) | (vaddr & ((1u << config.pageBits) - 1));
+            return true;
+        }
+    }
+    misses++;
+    return false;
+}
+
+uint32_t Tlb::pteAddress(uint32_t vaddr, int level) const
+{
+    int prefixBits = 0;
+    for (int i = 0; i <= level; ++i)
+        prefixBits += levelBits[i];
+    uint32_t prefix = (vaddr >> config.pageBits) >> (32 - config.pageBits - prefixBits);
+    return levelBase[level] + 4 * prefix;
+}
+
+uint32_t Tlb::fill(uint32_t vaddr, uint64_t cycles)
+{
+    walkCycles += cycles;
+    uint32_t page = vaddr >> config.pageBits;
+    uint32_t frame = mapper->frameOf(page);
+    Entry *set = &entries[(page % numSets) * config.ways];
+    Entry *victim = &set[0];
+    for (int way = 0; way < config.ways; ++way)
+    {
+        if (!set[way].valid)
+        {
+            victim = &set[way];
+            break;
+        }
+        if (set[way].lastUse < victim->lastUse)
+            victim = &set[way];
+    }
+    *victim = Entry{true, page, frame, ++useClock};
+    return (frame << config.pageBits) | (vaddr & ((1u << config.pageBits) - 1));
+}
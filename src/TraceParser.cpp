@@ -1,4 +1,6 @@
 #include "../header/TraceParser.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -14,6 +16,7 @@ std::vector<Instruction> TraceParser::parseTraceFile(const std::string &filename
     }
 
     std::string line;
+    uint64_t pendingGap = 0; // From "C" records since the last access.
     while (std::getline(infile, line))
     {
         if (line.empty())
@@ -22,10 +25,28 @@ std::vector<Instruction> TraceParser::parseTraceFile(const std::string &filename
         std::istringstream iss(line);
         char opChar;
         std::string addrStr;
-        if (!(iss >> opChar >> addrStr))
+        if (!(iss >> opChar))
             continue;
+        // Fences have no address; an optional field is their gap.
+        bool fence = (opChar == 'F' || opChar == 'f');
+        if (fence)
+            addrStr = "0";
+        else if (!(iss >> addrStr))
+            continue;
+
+        if (opChar == 'C' || opChar == 'c')
+        {
+            pendingGap += std::strtoull(addrStr.c_str(), nullptr, 10);
+            continue;
+        }
 
         Instruction inst;
+        uint64_t accessGap = 0;
+        if (iss >> accessGap)
+            pendingGap += accessGap;
+        inst.gap = static_cast<uint32_t>(std::min<uint64_t>(pendingGap, UINT32_MAX));
+        pendingGap = 0;
+
         if (opChar == 'R' || opChar == 'r')
         {
             inst.op = OperationType::READ;
@@ -34,6 +55,14 @@ std::vector<Instruction> TraceParser::parseTraceFile(const std::string &filename
         {
             inst.op = OperationType::WRITE;
         }
+        else if (opChar == 'A' || opChar == 'a')
+        {
+            inst.op = OperationType::ATOMIC;
+        }
+        else if (fence)
+        {
+            inst.op = OperationType::FENCE;
+        }
 
         uint32_t address;
         std::istringstream(addrStr) >> std::hex >> address;
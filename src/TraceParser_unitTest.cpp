@@ -6,7 +6,7 @@
 
 int main()
 {
-    // Create a temporary trace file with 5 instructions.
+    // Create a temporary trace file with 7 instructions.
     std::string testFilename = "test_trace.txt";
     std::ofstream outfile(testFilename);
     if (!outfile)
@@ -17,9 +17,15 @@ int main()
     // Write test instructions to the file.
     outfile << "R 0x7e1afe78\n";
     outfile << "W 0x7e1ac04c\n";
+    outfile << "C 12\n";
+    outfile << "C 8\n";
     outfile << "R 0x7e1afe80\n";
-    outfile << "W 0x7e1afe90\n";
-    outfile << "R 0x7e1afeA0\n";
+    outfile << "W 0x7e1afe90 5\n";
+    outfile << "C 3\n";
+    outfile << "R 0x7e1afeA0 4\n";
+    outfile << "A 0x7e1afeb0\n";
+    outfile << "F 2\n";
+    outfile << "C 100\n";
     outfile.close();
 
     // Parse the trace file.
@@ -29,20 +35,39 @@ int main()
     std::cout << "Parsed " << instructions.size() << " instructions." << std::endl;
 
     // Display each instruction's details.
+    const char *opNames[] = {"READ", "WRITE", "ATOMIC", "FENCE"};
     for (size_t i = 0; i < instructions.size(); ++i)
     {
         std::cout << "Instruction " << i + 1 << ": "
-                  << (instructions[i].op == OperationType::READ ? "READ" : "WRITE")
-                  << " " << std::hex << instructions[i].address << std::dec << std::endl;
+                  << opNames[static_cast<int>(instructions[i].op)]
+                  << " " << std::hex << instructions[i].address << std::dec
+                  << " gap " << instructions[i].gap << std::endl;
     }
 
     // Simple assertions to check correctness.
-    if (instructions.size() != 5)
+    if (instructions.size() != 7)
     {
-        std::cerr << "Test failed: Expected 5 instructions, got " << instructions.size() << std::endl;
+        std::cerr << "Test failed: Expected 7 instructions, got " << instructions.size() << std::endl;
         return 1;
     }
-    // (Optional) Further tests can check specific instruction values if desired.
+    // Atomics keep their address; a fence has none, and its field is a gap.
+    if (instructions[5].op != OperationType::ATOMIC || instructions[5].address != 0x7e1afeb0 ||
+        instructions[6].op != OperationType::FENCE || instructions[6].address != 0)
+    {
+        std::cerr << "Test failed: Atomic or fence record misparsed" << std::endl;
+        return 1;
+    }
+    // Compute gaps: "C" records and the third field add up; a trailing gap is dropped.
+    const uint32_t expectedGaps[7] = {0, 0, 20, 5, 7, 0, 2};
+    for (size_t i = 0; i < instructions.size(); ++i)
+    {
+        if (instructions[i].gap != expectedGaps[i])
+        {
+            std::cerr << "Test failed: Instruction " << i + 1 << " has gap " << instructions[i].gap
+                      << ", expected " << expectedGaps[i] << std::endl;
+            return 1;
+        }
+    }
 
     std::cout << "TraceParser test passed successfully." << std::endl;
     return 0;
@@ -0,0 +1,246 @@
+#include "WorkloadGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+// Address map: one shared region, then one private region per core.
+static const uint32_t SHARED_REGION_BASE = 0x10000000;
+static const uint32_t PRIVATE_REGION_BASE = 0x40000000;
+// Zipf popularity is tracked for at most this many distinct words.
+static const uint32_t MAX_ZIPF_ITEMS = 1 << 20;
+// Granularity of migratory objects and the lock word's neighbours.
+static const uint32_t OBJECT_BYTES = 64;
+// Default share of the generators whose point is sharing; the others
+// default to private data only.
+static const double SHARING_KIND_SHARE = 0.25;
+
+bool parseWorkloadSpec(const std::string &spec, WorkloadConfig &config)
+{
+    config.spec = spec;
+    std::string kind = spec.substr(0, spec.find(':'));
+    if (kind == "stride")
+        config.kind = WorkloadKind::Stride;
+    else if (kind == "uniform")
+        config.kind = WorkloadKind::Uniform;
+    else if (kind == "zipf")
+        config.kind = WorkloadKind::Zipf;
+    else if (kind == "prodcons")
+        config.kind = WorkloadKind::ProdCons;
+    else if (kind == "migratory")
+        config.kind = WorkloadKind::Migratory;
+    else if (kind == "lock")
+        config.kind = WorkloadKind::LockPingPong;
+    else
+    {
+        std::cerr << "Unknown workload '" << kind
+                  << "' (expected stride, uniform, zipf, prodcons, migratory or lock)" << std::endl;
+        return false;
+    }
+    if (config.kind == WorkloadKind::ProdCons || config.kind == WorkloadKind::Migratory ||
+        config.kind == WorkloadKind::LockPingPong)
+        config.share = SHARING_KIND_SHARE;
+
+    size_t colon = spec.find(':');
+    std::istringstream knobs(colon == std::string::npos ? std::string() : spec.substr(colon + 1));
+    std::string knob;
+    while (std::getline(knobs, knob, ','))
+    {
+        size_t eq = knob.find('=');
+        if (eq == std::string::npos)
+        {
+            std::cerr << "Malformed workload knob '" << knob << "' (expected key=value)" << std::endl;
+            return false;
+        }
+        std::string key = knob.substr(0, eq);
+        std::string value = knob.substr(eq + 1);
+        try
+        {
+            if (key == "count")
+                config.count = std::stoull(value, nullptr, 0);
+            else if (key == "footprint")
+                config.footprint = static_cast<uint32_t>(std::stoul(value, nullptr, 0));
+            else if (key == "stride")
+                config.stride = static_cast<uint32_t>(std::stoul(value, nullptr, 0));
+            else if (key == "share")
+                config.share = std::stod(value);
+            else if (key == "write")
+                config.writeRatio = std::stod(value);
+            else if (key == "alpha")
+                config.zipfAlpha = std::stod(value);
+            else if (key == "seed")
+                config.seed = std::stoull(value, nullptr, 0);
+            else if (key == "gap")
+                config.gap = static_cast<uint32_t>(std::stoul(value, nullptr, 0));
+            else if (key == "atomic")
+                config.atomic = std::stoul(value, nullptr, 0) != 0;
+            else
+            {
+                std::cerr << "Unknown workload knob '" << key << "'" << std::endl;
+                return false;
+            }
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for workload knob '" << key << "': " << value << std::endl;
+            return false;
+        }
+    }
+
+    if (config.footprint < OBJECT_BYTES * 2)
+    {
+        std::cerr << "Workload footprint must be at least " << OBJECT_BYTES * 2 << " bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+SyntheticSource::SyntheticSource(const WorkloadConfig &config, int coreId)
+    : config(config),
+      coreId(coreId),
+      produced(0),
+      rng(config.seed * 0x9E3779B97F4A7C15ULL + coreId),
+      unit(0.0, 1.0),
+      cursor(0)
+{
+    // Private regions are page aligned and laid out back to back.
+    uint32_t regionBytes = (config.footprint + 4095) & ~4095u;
+    privateBase = PRIVATE_REGION_BASE + coreId * regionBytes;
+    sharedBase = SHARED_REGION_BASE;
+    words = config.footprint / 4;
+
+    if (config.kind == WorkloadKind::Zipf)
+    {
+        uint32_t items = std::min(words, MAX_ZIPF_ITEMS);
+        zipfCdf.resize(items);
+        double sum = 0.0;
+        for (uint32_t i = 0; i < items; ++i)
+        {
+            sum += 1.0 / std::pow(i + 1.0, config.zipfAlpha);
+            zipfCdf[i] = sum;
+        }
+        for (auto &c : zipfCdf)
+            c /= sum;
+    }
+}
+
+// Draws a word offset whose popularity follows the zipfian CDF.
+// Ranks are scattered over the footprint so hot words do not share a set.
+uint32_t SyntheticSource::zipfWord()
+{
+    double u = unit(rng);
+    uint32_t rank = static_cast<uint32_t>(std::lower_bound(zipfCdf.begin(), zipfCdf.end(), u) - zipfCdf.begin());
+    if (rank >= zipfCdf.size())
+        rank = zipfCdf.size() - 1;
+    uint32_t wordsPerItem = words / zipfCdf.size();
+    uint32_t item = static_cast<uint32_t>((rank * 2654435761ULL) % zipfCdf.size());
+    return item * wordsPerItem * 4;
+}
+
+bool SyntheticSource::next(Instruction &inst)
+{
+    if (produced >= config.count)
+        return false;
+    produced++;
+    inst.gap = config.gap;
+
+    uint32_t numObjects = config.footprint / OBJECT_BYTES;
+    switch (config.kind)
+    {
+    case WorkloadKind::Stride:
+    {
+        uint32_t base = chance(config.share) ? sharedBase : privateBase;
+        inst.op = randomOp();
+        inst.address = base + static_cast<uint32_t>((cursor++ * config.stride) % config.footprint);
+        break;
+    }
+    case WorkloadKind::Uniform:
+    {
+        uint32_t base = chance(config.share) ? sharedBase : privateBase;
+        inst.op = randomOp();
+        inst.address = base + randomWord();
+        break;
+    }
+    case WorkloadKind::Zipf:
+    {
+        uint32_t base = chance(config.share) ? sharedBase : privateBase;
+        inst.op = randomOp();
+        inst.address = base + zipfWord();
+        break;
+    }
+    case WorkloadKind::ProdCons:
+    {
+        if (chance(config.share))
+        {
+            // Each even/odd core pair shares one ring buffer.
+            uint32_t buffer = sharedBase + (coreId / 2) * ((config.footprint + 4095) & ~4095u);
+            inst.op = (coreId % 2 == 0) ? OperationType::WRITE : OperationType::READ;
+            inst.address = buffer + static_cast<uint32_t>((cursor++ % words) * 4);
+        }
+        else
+        {
+            inst.op = randomOp();
+            inst.address = privateBase + randomWord();
+        }
+        break;
+    }
+    case WorkloadKind::Migratory:
+    {
+        // cursor's low bit marks the write half of a read-modify-write.
+        if (cursor & 1)
+        {
+            inst.op = OperationType::WRITE;
+            inst.address = sharedBase + static_cast<uint32_t>(((cursor >> 1) + coreId) % numObjects) * OBJECT_BYTES;
+            cursor++;
+        }
+        else if (chance(config.share))
+        {
+            inst.op = OperationType::READ;
+            inst.address = sharedBase + static_cast<uint32_t>(((cursor >> 1) + coreId) % numObjects) * OBJECT_BYTES;
+            cursor++;
+        }
+        else
+        {
+            inst.op = randomOp();
+            inst.address = privateBase + randomWord();
+        }
+        break;
+    }
+    case WorkloadKind::LockPingPong:
+    {
+        // One episode: 4 spin reads, acquire, 4 critical-section accesses,
+        // release, then private work sized so that `share` of all accesses
+        // touch the lock or the data it protects.
+        const uint64_t sharedPhase = 10;
+        uint64_t privatePhase = (config.share > 0.0)
+                                    ? static_cast<uint64_t>(sharedPhase * (1.0 - config.share) / config.share)
+                                    : UINT32_MAX;
+        uint64_t step = cursor % (sharedPhase + privatePhase);
+        cursor++;
+        uint32_t lockWord = sharedBase;
+        if (step < 4)
+        {
+            inst.op = OperationType::READ;
+            inst.address = lockWord;
+        }
+        else if (step == 4 || step == 9)
+        {
+            inst.op = (step == 4 && config.atomic) ? OperationType::ATOMIC : OperationType::WRITE;
+            inst.address = lockWord;
+        }
+        else if (step < sharedPhase)
+        {
+            inst.op = randomOp();
+            inst.address = sharedBase + OBJECT_BYTES + ((randomWord() % (config.footprint - OBJECT_BYTES)) & ~3u);
+        }
+        else
+        {
+            inst.op = randomOp();
+            inst.address = privateBase + randomWord();
+        }
+        break;
+    }
+    }
+    return true;
+}
@@ -0,0 +1,303 @@
+#include "l1sim.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include "Simulator.hpp"
+
+struct l1sim {
+    SimulationConfig config;
+    std::unique_ptr<Simulator> sim; // Built on the first feed, load or step.
+    std::vector<BatchSource*> sources; // Owned by the processors.
+    std::string error;
+};
+
+// Spec parsers report problems on std::cerr; capture them as the handle's
+// error instead. std::cerr is process-wide, so captures are serialised.
+static std::mutex cerrMutex;
+
+class ErrorCapture {
+public:
+    explicit ErrorCapture(std::string &error)
+        : error(error), lock(cerrMutex), saved(std::cerr.rdbuf(buffer.rdbuf()))
+    {
+    }
+    ~ErrorCapture()
+    {
+        std::cerr.rdbuf(saved);
+        std::string message = buffer.str();
+        while (!message.empty() && message.back() == '\n')
+            message.pop_back();
+        if (!message.empty())
+            error = message;
+    }
+
+private:
+    std::string &error;
+    std::lock_guard<std::mutex> lock;
+    std::ostringstream buffer;
+    std::streambuf *saved;
+};
+
+static int fail(l1sim *sim, const std::string &message)
+{
+    sim->error = message;
+    return -1;
+}
+
+// Builds the system on first use; later calls are no-ops.
+static int build(l1sim *sim)
+{
+    if (sim->sim)
+        return 0;
+    {
+        ErrorCapture capture(sim->error);
+        if (!checkSimulationConfig(sim->config))
+            return -1;
+    }
+    std::vector<InstructionSource*> sources;
+    for (int i = 0; i < sim->config.numCores; ++i)
+    {
+        sim->sources.push_back(new BatchSource());
+        sources.push_back(sim->sources.back());
+    }
+    sim->sim.reset(new Simulator(sim->config, sources));
+    return 0;
+}
+
+static bool parseInt(const char *value, int &out)
+{
+    if (!value)
+        return false;
+    char *end;
+    long parsed = std::strtol(value, &end, 0);
+    if (end == value || *end != '\0')
+        return false;
+    out = static_cast<int>(parsed);
+    return true;
+}
+
+//------------------------------------------------------------------
+extern "C" {
+
+int l1sim_api_version(void)
+{
+    return L1SIM_API_VERSION;
+}
+
+l1sim *l1sim_create(int s, int E, int b, int cores)
+{
+    if (s < 0 || s > 24 || E < 1 || b < 2 || b > 16 || cores < 1 || cores > 64)
+        return nullptr;
+    l1sim *sim = new l1sim();
+    sim->config.s = s;
+    sim->config.E = E;
+    sim->config.b = b;
+    sim->config.numCores = cores;
+    return sim;
+}
+
+void l1sim_destroy(l1sim *sim)
+{
+    delete sim;
+}
+
+const char *l1sim_last_error(const l1sim *sim)
+{
+    return sim ? sim->error.c_str() : "null handle";
+}
+
+int l1sim_set_option(l1sim *sim, const char *name, const char *value)
+{
+    if (!sim || !name)
+        return -1;
+    if (sim->sim)
+        return fail(sim, "options must be set before the first feed, load or step");
+    SimulationConfig &config = sim->config;
+    std::string option = name;
+    std::string text = value ? value : "";
+    ErrorCapture capture(sim->error);
+
+    if (option == "generic-cache")
+        config.genericCache = true;
+    else if (option == "l2-noninclusive")
+        config.l2Inclusive = false;
+    else if (!value)
+        return fail(sim, "option '" + option + "' needs a value");
+    else if (option == "prefetch")
+    {
+        if (!parsePrefetcherKind(text, config.prefetcher))
+            return fail(sim, "unknown prefetcher '" + text + "'");
+    }
+    else if (option == "prefetch-degree")
+    {
+        if (!parseInt(value, config.prefetchDegree) || config.prefetchDegree < 1)
+            return fail(sim, "prefetch degree must be a positive integer");
+    }
+    else if (option == "store-buffer")
+    {
+        if (!parseInt(value, config.storeBufferEntries) || config.storeBufferEntries < 0)
+            return fail(sim, "store buffer size must be a non-negative integer");
+    }
+    else if (option == "victim")
+    {
+        if (!parseInt(value, config.victimEntries) || config.victimEntries < 0)
+            return fail(sim, "victim cache size must be a non-negative integer");
+    }
+    else if (option == "l2")
+    {
+        if (std::sscanf(value, "%d,%d,%d", &config.l2s, &config.l2E, &config.l2b) != 3)
+            return fail(sim, "L2 geometry must be <s>,<E>,<b>");
+        config.useL2 = true;
+    }
+    else if (option == "l2-latency")
+    {
+        if (!parseInt(value, config.l2Latency) || config.l2Latency < 0)
+            return fail(sim, "L2 latency must be a non-negative integer");
+    }
+    else if (option == "dram")
+    {
+        if (!parseDramSpec(text, config.dram))
+            return -1;
+        config.useDram = true;
+    }
+    else if (option == "writeback-buffer")
+    {
+        if (!parseInt(value, config.writebackBufferEntries) || config.writebackBufferEntries < 0)
+            return fail(sim, "write-back buffer size must be a non-negative integer");
+    }
+    else if (option == "arbitration")
+    {
+        if (!parseArbitrationPolicy(text, config.arbitration))
+            return fail(sim, "unknown arbitration policy '" + text + "'");
+        config.reportBusWait = true;
+    }
+    else if (option == "directory")
+    {
+        if (!parseDirectorySpec(text, config.directory))
+            return -1;
+        config.useDirectory = true;
+    }
+    else if (option == "tlb")
+    {
+        if (!parseTlbSpec(text, config.tlb))
+            return -1;
+        config.useTlb = true;
+    }
+    else
+        return fail(sim, "unknown option '" + option + "'");
+    return 0;
+}
+
+int l1sim_feed(l1sim *sim, int core, const l1sim_access *accesses, size_t count)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    if (core < 0 || core >= sim->config.numCores)
+        return fail(sim, "core out of range");
+    if (count > 0 && !accesses)
+        return fail(sim, "null access array");
+    BatchSource *source = sim->sources[core];
+    for (size_t i = 0; i < count; ++i)
+    {
+        Instruction inst;
+        static const OperationType ops[] = {OperationType::READ, OperationType::WRITE,
+                                            OperationType::ATOMIC, OperationType::FENCE};
+        inst.op = (accesses[i].op < 4) ? ops[accesses[i].op] : OperationType::READ;
+        inst.address = (inst.op == OperationType::FENCE) ? 0 : accesses[i].address;
+        source->append(inst);
+    }
+    sim->sim->resume();
+    return 0;
+}
+
+int l1sim_load_trace(l1sim *sim, int core, const char *path)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    if (core < 0 || core >= sim->config.numCores)
+        return fail(sim, "core out of range");
+    if (!path || !std::ifstream(path).is_open())
+        return fail(sim, std::string("cannot open trace file ") + (path ? path : "(null)"));
+    for (const Instruction &inst : TraceParser::parseTraceFile(path))
+        sim->sources[core]->append(inst);
+    sim->sim->resume();
+    return 0;
+}
+
+int l1sim_step(l1sim *sim, uint64_t cycles)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    return sim->sim->step(cycles) ? 1 : 0;
+}
+
+int l1sim_run(l1sim *sim)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    if (!sim->sim->isFinished())
+        sim->sim->run();
+    return 0;
+}
+
+int l1sim_get_core_stats(l1sim *sim, int core, l1sim_core_stats *stats, size_t size)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    if (core < 0 || core >= sim->config.numCores)
+        return fail(sim, "core out of range");
+    if (!stats)
+        return fail(sim, "null stats pointer");
+    const Processor *proc = sim->sim->getProcessors()[core];
+    const Cache *cache = sim->sim->getCaches()[core];
+    l1sim_core_stats all;
+    all.instructions = proc->getTotalInstructions();
+    all.retired = proc->getInstructionsExecuted();
+    all.reads = proc->getTotalReads();
+    all.writes = proc->getTotalWrites();
+    all.execution_cycles = proc->getTotalCycles() - proc->getIdleCycles();
+    all.idle_cycles = proc->getIdleCycles();
+    all.cache_misses = cache->getCacheMisses();
+    all.cache_evictions = cache->getEvictions();
+    all.writebacks = cache->getWritebacks();
+    all.bus_invalidations = cache->getBusInvalidations();
+    all.data_traffic_bytes = cache->getDataTrafficBytes();
+    std::memcpy(stats, &all, std::min(size, sizeof(all)));
+    return 0;
+}
+
+int l1sim_get_bus_stats(l1sim *sim, l1sim_bus_stats *stats, size_t size)
+{
+    if (!sim)
+        return -1;
+    if (build(sim) != 0)
+        return -1;
+    if (!stats)
+        return fail(sim, "null stats pointer");
+    Bus &bus = sim->sim->getBus();
+    l1sim_bus_stats all;
+    all.cycles = sim->sim->getGlobalClock();
+    all.transactions = bus.getTotalBusTransactions();
+    all.traffic_bytes = bus.updateBusTrafficBytes(sim->sim->getCaches());
+    std::memcpy(stats, &all, std::min(size, sizeof(all)));
+    return 0;
+}
+
+} // extern "C"
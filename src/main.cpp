@@ -2,32 +2,29 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <iomanip>
+#include <chrono>
+#include <sstream>
+#include <memory>
+#include <map>
+#include <algorithm>
 #include "Processor.hpp"
 #include "Cache.hpp"
 #include "Bus.hpp"
-
-#ifdef DEBUG
-#include "Debug.hpp"
-#endif
-
-// Structure for simulation configuration.
-struct SimulationConfig {
-    std::string tracePrefix;
-    int s; // Number of set index bits.
-    int E; // Associativity.
-    int b; // Block bits (block size in bytes = 2^b).
-    std::string outputFilename;
-};
+#include "Profiler.hpp"
+#include "Simulator.hpp"
+#include "Estimator.hpp"
+#include "WorkloadGenerator.hpp"
+#include "ResultCache.hpp"
 
 // Simple command-line parser.
 SimulationConfig parseArguments(int argc, char *argv[]) {
-    SimulationConfig config;
-    // Default values.
-    config.s = 4; // e.g., 16 sets.
-    config.E = 2; // 2-way set associative.
-    config.b = 5; // e.g., block size = 2^5 = 32 bytes.
-    config.outputFilename = "output.log";
+    SimulationConfig config; // Defaults are in SimulationConfig.
+    if (const char *dir = std::getenv("L1SIM_RESULT_CACHE")) {
+        config.resultCacheDir = dir;
+    }
 
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
@@ -45,19 +42,221 @@ SimulationConfig parseArguments(int argc, char *argv[]) {
         else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             config.outputFilename = argv[++i];
         }
+        else if (strcmp(argv[i], "--profile") == 0) {
+            config.profile = true;
+        }
+        else if (strcmp(argv[i], "--predecode") == 0) {
+            config.predecode = true;
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            if (!parseWorkloadSpec(argv[++i], config.workload)) {
+                exit(1);
+            }
+            config.useWorkload = true;
+        }
+        else if (strcmp(argv[i], "--estimate") == 0) {
+            config.estimate = true;
+        }
+        else if (strcmp(argv[i], "--generic-cache") == 0) {
+            config.genericCache = true;
+        }
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) {
+            if (!parsePrefetcherKind(argv[++i], config.prefetcher)) {
+                std::cerr << "Unknown prefetcher '" << argv[i]
+                          << "' (expected none, nextline, stride or stream)" << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--prefetch-degree") == 0 && i + 1 < argc) {
+            config.prefetchDegree = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--store-buffer") == 0 && i + 1 < argc) {
+            config.storeBufferEntries = std::stoi(argv[++i]);
+            if (config.storeBufferEntries < 0) {
+                std::cerr << "Store buffer size must be non-negative" << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--tlb") == 0 && i + 1 < argc) {
+            if (!parseTlbSpec(argv[++i], config.tlb)) {
+                exit(1);
+            }
+            config.useTlb = true;
+        }
+        else if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc) {
+            config.parallelQuantum = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--quantum-sweep") == 0 && i + 1 < argc) {
+            std::istringstream quanta(argv[++i]);
+            std::string q;
+            while (std::getline(quanta, q, ',')) {
+                config.quantumSweep.push_back(std::stoi(q));
+            }
+        }
+        else if (strcmp(argv[i], "--victim") == 0 && i + 1 < argc) {
+            config.victimEntries = std::stoi(argv[++i]);
+            if (config.victimEntries < 0) {
+                std::cerr << "Victim cache size must be non-negative" << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--l2") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d,%d,%d", &config.l2s, &config.l2E, &config.l2b) != 3) {
+                std::cerr << "Expected --l2 <s>,<E>,<b>" << std::endl;
+                exit(1);
+            }
+            config.useL2 = true;
+        }
+        else if (strcmp(argv[i], "--l2-latency") == 0 && i + 1 < argc) {
+            config.l2Latency = std::stoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--l2-noninclusive") == 0) {
+            config.l2Inclusive = false;
+        }
+        else if (strcmp(argv[i], "--dram") == 0 && i + 1 < argc) {
+            if (!parseDramSpec(argv[++i], config.dram)) {
+                exit(1);
+            }
+            config.useDram = true;
+        }
+        else if (strcmp(argv[i], "--writeback-buffer") == 0 && i + 1 < argc) {
+            config.writebackBufferEntries = std::stoi(argv[++i]);
+            if (config.writebackBufferEntries < 0) {
+                std::cerr << "Write-back buffer size must be non-negative" << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--arbitration") == 0 && i + 1 < argc) {
+            if (!parseArbitrationPolicy(argv[++i], config.arbitration)) {
+                std::cerr << "Unknown arbitration policy '" << argv[i]
+                          << "' (expected fifo, rr, priority or age)" << std::endl;
+                exit(1);
+            }
+            config.reportBusWait = true;
+        }
+        else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+            config.numCores = std::stoi(argv[++i]);
+            if (config.numCores < 1 || config.numCores > 64) {
+                std::cerr << "Core count must be between 1 and 64" << std::endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--directory") == 0 && i + 1 < argc) {
+            if (!parseDirectorySpec(argv[++i], config.directory)) {
+                exit(1);
+            }
+            config.useDirectory = true;
+        }
+        else if (strcmp(argv[i], "--clusters") == 0 && i + 1 < argc) {
+            if (!parseClusterSpec(argv[++i], config.cluster)) {
+                exit(1);
+            }
+            config.useClusters = true;
+        }
+        else if (strcmp(argv[i], "--snapshot-interval") == 0 && i + 1 < argc) {
+            config.snapshotInterval = std::stoull(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--snapshot-file") == 0 && i + 1 < argc) {
+            config.snapshotFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--simpoints") == 0 && i + 1 < argc) {
+            config.simpointFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--simpoint-warmup") == 0 && i + 1 < argc) {
+            config.simpointWarmup = std::stoull(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--event-trace") == 0 && i + 1 < argc) {
+            config.eventTraceFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--event-cores") == 0 && i + 1 < argc) {
+            if (!parseTraceCores(argv[++i], config.eventFilter.coreMask)) {
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--event-addr") == 0 && i + 1 < argc) {
+            uint64_t low, high;
+            if (!parseTraceRange(argv[++i], low, high)) {
+                exit(1);
+            }
+            if (high > UINT32_MAX) {
+                std::cerr << "Address range must lie within 32 bits" << std::endl;
+                exit(1);
+            }
+            config.eventFilter.addressLow = static_cast<uint32_t>(low);
+            config.eventFilter.addressHigh = static_cast<uint32_t>(high);
+        }
+        else if (strcmp(argv[i], "--event-cycles") == 0 && i + 1 < argc) {
+            if (!parseTraceRange(argv[++i], config.eventFilter.cycleFrom, config.eventFilter.cycleTo)) {
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "--result-cache") == 0 && i + 1 < argc) {
+            config.resultCacheDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-result-cache") == 0) {
+            config.resultCacheDir.clear();
+        }
+        else if (strcmp(argv[i], "--refresh-result-cache") == 0) {
+            config.refreshResultCache = true;
+        }
         else if (strcmp(argv[i], "-h") == 0) {
             std::cout << "Usage: " << argv[0]
-                      << " -t <tracePrefix> -s <s> -E <E> -b <b> -o <outputFilename>\n";
+                      << " -t <tracePrefix> -s <s> -E <E> -b <b> -o <outputFilename> [--profile]\n"
+                      << "       -w <kind>[:key=value,...] replaces -t with a generated workload\n"
+                      << "          kinds: stride uniform zipf prodcons migratory lock\n"
+                      << "          knobs: count footprint stride share write alpha seed gap atomic\n"
+                      << "       --predecode loads traces as same-block runs of block IDs and charges guaranteed-hit runs in one step\n"
+                      << "       --estimate skips the cycle loop: functional MESI caches plus a bus queueing model\n"
+                      << "       --generic-cache uses the runtime cache even for the specialised geometries\n"
+                      << "       --prefetch <none|nextline|stride|stream> [--prefetch-degree <n>] adds an L1 prefetcher\n"
+                      << "       --store-buffer <entries> retires stores into a per-core TSO store buffer\n"
+                      << "       --tlb <identity|random|color>[:key=value,...] translates trace addresses through per-core TLBs\n"
+                      << "          knobs: entries ways page levels penalty seed\n"
+                      << "       --victim <entries> adds a fully-associative victim cache to every L1\n"
+                      << "       --l2 <s>,<E>,<b> [--l2-latency <cycles>] [--l2-noninclusive] adds a shared L2\n"
+                      << "       --dram <open|closed>[:key=value,...] models DRAM banks and row buffers\n"
+                      << "          knobs: banks row trcd tcl trp burst\n"
+                      << "       --writeback-buffer <entries> drains write-backs over a separate channel\n"
+                      << "       --arbitration <fifo|rr|priority|age> picks the bus arbitration policy\n"
+                      << "       --cores <n> simulates n cores (default 4, at most 64)\n"
+                      << "       --directory <full|limited>[:key=value,...] replaces the bus with a directory on a 2-D mesh\n"
+                      << "          knobs: pointers hop flit lookup\n"
+                      << "       --clusters <n>[:key=value,...] splits the cores over n snooping buses joined by a global interconnect\n"
+                      << "          knobs: latency bandwidth header\n"
+                      << "       --snapshot-interval <cycles> [--snapshot-file <path>] appends progress snapshots\n"
+                      << "          (CSV, or JSON lines for .json/.jsonl paths; default snapshots.csv)\n"
+                      << "       --simpoints <file> [--simpoint-warmup <instructions>] simulates only the slices\n"
+                      << "          picked by tools/simpoint and prints weighted whole-run estimates\n"
+                      << "       --event-trace <path> [--event-cores <i,j,...>] [--event-addr <lo>-<hi>] [--event-cycles <from>-<to>]\n"
+                      << "          records cache, snoop, bus and processor events (builds from make debug only)\n"
+                      << "       --parallel <quantum> runs each core on its own host thread\n"
+                      << "       --quantum-sweep <q1,q2,...> compares parallel runs against the serial loop\n"
+                      << "       --result-cache <dir> replays the output of an identical earlier run (default $L1SIM_RESULT_CACHE)\n"
+                      << "          keyed by this binary, the options and the trace contents;\n"
+                      << "          --no-result-cache bypasses it, --refresh-result-cache re-runs and overwrites the entry\n";
             exit(0);
         }
     }
+    if (!checkSimulationConfig(config)) {
+        exit(1);
+    }
     return config;
 }
 
 // Function to print simulation parameters.
 void printSimulationParameters(const SimulationConfig &config, int numSets, int cacheSizeKB) {
     std::cout << "Simulation Parameters:\n";
-    std::cout << "Trace Prefix: " << config.tracePrefix << "\n";
+    if (config.useWorkload) {
+        std::cout << "Workload: " << config.workload.spec << "\n";
+    } else {
+        std::cout << "Trace Prefix: " << config.tracePrefix << "\n";
+        if (config.predecode) {
+            std::cout << "Trace Pre-decoding: Enabled (same-block runs)\n";
+        }
+    }
+    if (config.numCores != 4) {
+        std::cout << "Cores: " << config.numCores << "\n";
+    }
     std::cout << "Set Index Bits: " << config.s << "\n";
     std::cout << "Associativity: " << config.E << "\n";
     std::cout << "Block Bits: " << config.b << "\n";
@@ -68,27 +267,86 @@ void printSimulationParameters(const SimulationConfig &config, int numSets, int
     std::cout << "MESI Protocol: Enabled\n";
     std::cout << "Write Policy: Write-back, Write-allocate\n";
     std::cout << "Replacement Policy: LRU\n";
-    std::cout << "Bus: Central snooping bus\n\n";
+    if (config.prefetcher != PrefetcherKind::None) {
+        std::cout << "Prefetcher: " << prefetcherKindName(config.prefetcher)
+                  << " (degree " << config.prefetchDegree << ")\n";
+    }
+    if (config.useTlb) {
+        const TlbConfig &t = config.tlb;
+        std::cout << "TLB: " << t.entries << " entries per core, " << t.ways << "-way, "
+                  << (1 << t.pageBits) << "-byte pages, " << t.levels << "-level walk + "
+                  << t.missPenalty << " cycles, " << pageMappingName(t.mapping) << " page mapping\n";
+    }
+    if (config.victimEntries > 0) {
+        std::cout << "Victim Cache: " << config.victimEntries << " lines per core, fully associative\n";
+    }
+    if (config.useL2) {
+        int l2SizeKB = ((1 << config.l2s) * config.l2E * (1 << config.l2b)) / 1024;
+        std::cout << "Shared L2: " << l2SizeKB << " KB, " << config.l2E << "-way, "
+                  << (1 << config.l2b) << "-byte blocks, " << config.l2Latency << "-cycle hits, "
+                  << (config.l2Inclusive ? "inclusive" : "non-inclusive") << "\n";
+    }
+    if (config.useDram) {
+        const DramConfig &d = config.dram;
+        std::cout << "DRAM: " << d.banks << " banks, " << d.rowBytes << "-byte rows, "
+                  << (d.openPage ? "open" : "closed") << " page, tRCD/tCL/tRP " << d.tRCD << "/"
+                  << d.tCL << "/" << d.tRP << ", burst " << d.burst << ", FR-FCFS\n";
+    }
+    if (config.storeBufferEntries > 0) {
+        std::cout << "Store Buffer: " << config.storeBufferEntries << " entries (TSO)\n";
+    }
+    if (config.writebackBufferEntries > 0) {
+        std::cout << "Write-Back Buffer: " << config.writebackBufferEntries << " blocks, dedicated write channel\n";
+    }
+    if (config.reportBusWait) {
+        std::cout << "Bus Arbitration: " << arbitrationPolicyName(config.arbitration) << "\n";
+    }
+    if (config.useDirectory) {
+        const DirectoryConfig &d = config.directory;
+        Mesh mesh(config.numCores, d.hopLatency);
+        std::cout << "Coherence: Directory (";
+        if (d.pointers > 0) {
+            std::cout << d.pointers << "-pointer limited";
+        } else {
+            std::cout << "full-map";
+        }
+        std::cout << "), " << mesh.getCols() << "x" << mesh.getRows() << " mesh, "
+                  << d.hopLatency << "-cycle hops, " << d.flitBytes << "-byte flits, "
+                  << d.lookupLatency << "-cycle lookup\n\n";
+    } else if (config.useClusters) {
+        const ClusterConfig &c = config.cluster;
+        std::cout << "Bus: " << c.clusters << " cluster snooping buses (" << config.numCores / c.clusters
+                  << " cores each), global interconnect with " << c.linkLatency << "-cycle latency, "
+                  << c.bytesPerCycle << " bytes/cycle per port, " << c.headerBytes << "-byte headers\n\n";
+    } else {
+        std::cout << "Bus: Central snooping bus\n\n";
+    }
 }
 
 // Function to print per-core statistics.
 // (This example assumes that your Processor and Cache classes
 // provide getters for all required counters. You may need to add them if not yet implemented.)
 void printCoreStatistics(const std::vector<Processor*>& processors, const std::vector<Cache*>& caches) {
+    // Only traces with compute gaps get the extra line.
+    bool hasCompute = false;
+    for (const Processor *proc : processors) {
+        hasCompute = hasCompute || proc->getComputeCycles() > 0;
+    }
     for (size_t i = 0; i < processors.size(); ++i) {
         // These functions should be implemented in your classes.
-        int totalInstr = processors[i]->getTotalInstructions();
-        int totalReads = processors[i]->getTotalReads();
-        int totalWrites = processors[i]->getTotalWrites();
-        int totalCycles = processors[i]->getTotalCycles();
-        int idleCycles = processors[i]->getIdleCycles();
-        int misses = caches[i]->getCacheMisses();
-        int accesses = totalReads + totalWrites;
+        uint64_t totalInstr = processors[i]->getTotalInstructions();
+        uint64_t totalReads = processors[i]->getTotalReads();
+        uint64_t totalWrites = processors[i]->getTotalWrites();
+        uint64_t totalCycles = processors[i]->getTotalCycles();
+        uint64_t idleCycles = processors[i]->getIdleCycles();
+        uint64_t misses = caches[i]->getCacheMisses();
+        // Page walks read through the L1 too.
+        uint64_t accesses = totalReads + totalWrites + processors[i]->getAtomics() + processors[i]->getPageTableReads();
         double missRate = (accesses > 0) ? (100.0 * misses / accesses) : 0.0;
-        int evictions = caches[i]->getEvictions();
-        int writebacks = caches[i]->getWritebacks();
-        int busInvalidations = caches[i]->getBusInvalidations();
-        int dataTraffic = caches[i]->getDataTrafficBytes();
+        uint64_t evictions = caches[i]->getEvictions();
+        uint64_t writebacks = caches[i]->getWritebacks();
+        uint64_t busInvalidations = caches[i]->getBusInvalidations();
+        uint64_t dataTraffic = caches[i]->getDataTrafficBytes();
 
         std::cout << "Core " << i << " Statistics:\n";
         std::cout << "Total Instructions: " << totalInstr << "\n";
@@ -96,6 +354,9 @@ void printCoreStatistics(const std::vector<Processor*>& processors, const std::v
         std::cout << "Total Writes: " << totalWrites << "\n";
         std::cout << "Total Execution Cycles: " << totalCycles - idleCycles << "\n";
         std::cout << "Idle Cycles: " << idleCycles << "\n";
+        if (hasCompute) {
+            std::cout << "Compute Cycles: " << processors[i]->getComputeCycles() << "\n";
+        }
         std::cout << "Cache Misses: " << misses << "\n";
         std::cout << "Cache Miss Rate: " << std::fixed << std::setprecision(2) << missRate << "%\n";
         std::cout << "Cache Evictions: " << evictions << "\n";
@@ -105,72 +366,493 @@ void printCoreStatistics(const std::vector<Processor*>& processors, const std::v
     }
 }
 
+// Function to print per-core prefetcher statistics.
+// Accuracy is useful/issued, coverage is the share of would-be misses that
+// prefetches removed, and timeliness is the share of useful prefetches that
+// arrived before their demand access.
+void printPrefetchStatistics(const std::vector<Cache*>& caches) {
+    for (size_t i = 0; i < caches.size(); ++i) {
+        uint64_t issued = caches[i]->getPrefetchesIssued();
+        uint64_t useful = caches[i]->getUsefulPrefetches();
+        uint64_t late = caches[i]->getLatePrefetches();
+        uint64_t unused = caches[i]->getUnusedPrefetches();
+        uint64_t misses = caches[i]->getCacheMisses();
+        double accuracy = (issued > 0) ? (100.0 * useful / issued) : 0.0;
+        double coverage = (useful + misses > 0) ? (100.0 * useful / (useful + misses)) : 0.0;
+        double timeliness = (useful + late > 0) ? (100.0 * useful / (useful + late)) : 0.0;
+
+        std::cout << "Core " << i << " Prefetch Statistics:\n";
+        std::cout << "Prefetches Issued: " << issued << "\n";
+        std::cout << "Useful Prefetches: " << useful << "\n";
+        std::cout << "Late Prefetches: " << late << "\n";
+        std::cout << "Unused Prefetches: " << unused << "\n";
+        std::cout << "Prefetch Accuracy: " << std::fixed << std::setprecision(2) << accuracy << "%\n";
+        std::cout << "Prefetch Coverage: " << coverage << "%\n";
+        std::cout << "Prefetch Timeliness: " << timeliness << "%\n";
+        std::cout << "Prefetch Traffic (Bytes): " << caches[i]->getPrefetchTrafficBytes() << "\n\n";
+    }
+}
+
+// Function to print per-core store buffer statistics.
+void printStoreBufferStatistics(const std::vector<Processor*>& processors) {
+    for (size_t i = 0; i < processors.size(); ++i) {
+        std::cout << "Core " << i << " Store Buffer Statistics:\n";
+        std::cout << "Stores Buffered: " << processors[i]->getStoresBuffered() << "\n";
+        std::cout << "Loads Forwarded: " << processors[i]->getLoadsForwarded() << "\n";
+        std::cout << "Store Stall Cycles Saved: " << processors[i]->getStoreStallCyclesSaved() << "\n";
+        std::cout << "Buffer-Full Stall Cycles: " << processors[i]->getStoreBufferFullStalls() << "\n\n";
+    }
+}
+
+// Function to print per-core TLB statistics.
+void printTlbStatistics(const Simulator &sim, int numCores) {
+    for (int i = 0; i < numCores; ++i) {
+        const Tlb *tlb = sim.getTlb(i);
+        uint64_t lookups = tlb->getLookups();
+        uint64_t misses = tlb->getMisses();
+        std::cout << "Core " << i << " TLB Statistics:\n";
+        std::cout << "TLB Lookups: " << lookups << "\n";
+        std::cout << "TLB Misses: " << misses << "\n";
+        std::cout << "TLB Miss Rate: " << std::fixed << std::setprecision(2)
+                  << (lookups > 0 ? 100.0 * misses / lookups : 0.0) << "%\n";
+        std::cout << "Page Table Reads: " << tlb->getPageTableReads() << "\n";
+        std::cout << "Page Walk Cycles: " << tlb->getWalkCycles() << "\n\n";
+    }
+    std::cout << "Pages Mapped: " << sim.getPageMapper()->getPagesMapped() << "\n\n";
+}
+
+// Function to print per-core victim cache statistics.
+void printVictimCacheStatistics(const std::vector<Cache*>& caches) {
+    for (size_t i = 0; i < caches.size(); ++i) {
+        uint64_t probes = caches[i]->getVictimProbes();
+        uint64_t hits = caches[i]->getVictimHits();
+        double hitRate = (probes > 0) ? (100.0 * hits / probes) : 0.0;
+        std::cout << "Core " << i << " Victim Cache Statistics:\n";
+        std::cout << "Victim Probes: " << probes << "\n";
+        std::cout << "Victim Hits: " << hits << "\n";
+        std::cout << "Victim Hit Rate: " << std::fixed << std::setprecision(2) << hitRate << "%\n";
+        std::cout << "Victim Cycles Saved: " << caches[i]->getVictimCyclesSaved() << "\n\n";
+    }
+}
+
+// Function to print shared L2 statistics.
+void printL2Statistics(const L2Cache &l2) {
+    uint64_t accesses = l2.getAccesses();
+    double missRate = (accesses > 0) ? (100.0 * l2.getMisses() / accesses) : 0.0;
+    std::cout << "Shared L2 Statistics:\n";
+    std::cout << "L2 Accesses: " << accesses << "\n";
+    std::cout << "L2 Hits: " << l2.getHits() << "\n";
+    std::cout << "L2 Misses: " << l2.getMisses() << "\n";
+    std::cout << "L2 Miss Rate: " << std::fixed << std::setprecision(2) << missRate << "%\n";
+    std::cout << "L2 Evictions: " << l2.getEvictions() << "\n";
+    std::cout << "L2 Writebacks: " << l2.getWritebacks() << "\n";
+    if (l2.isInclusive()) {
+        std::cout << "L2 Back-Invalidations: " << l2.getBackInvalidations() << "\n";
+        std::cout << "Dirty L1 Back-Invalidations: " << l2.getDirtyBackInvalidations() << "\n";
+    }
+    std::cout << "\n";
+}
+
+// Function to print DRAM statistics.
+void printDramStatistics(const Dram &dram) {
+    uint64_t requests = dram.getRequests();
+    double hitRate = (requests > 0) ? (100.0 * dram.getRowHits() / requests) : 0.0;
+    double avgLatency = (requests > 0) ? static_cast<double>(dram.getTotalLatency()) / requests : 0.0;
+    std::cout << "DRAM Statistics:\n";
+    std::cout << "DRAM Reads: " << dram.getReads() << "\n";
+    std::cout << "DRAM Writes: " << dram.getWrites() << "\n";
+    std::cout << "Row Hits: " << dram.getRowHits() << "\n";
+    std::cout << "Row Misses: " << dram.getRowMisses() << "\n";
+    std::cout << "Row Conflicts: " << dram.getRowConflicts() << "\n";
+    std::cout << "Row-Buffer Hit Rate: " << std::fixed << std::setprecision(2) << hitRate << "%\n";
+    std::cout << "Average Memory Latency (Cycles): " << avgLatency << "\n\n";
+}
+
+// Function to print per-core bus wait statistics (demand transactions).
+// Each core is granted by its own bus (its cluster's, with --clusters);
+// fairness is Jain's index over the cores' mean waits (1 = all equal).
+void printBusWaitStatistics(const Simulator &sim, int numCores) {
+    std::cout << "Bus Arbitration Statistics:\n";
+    double sum = 0.0, sumSquares = 0.0;
+    int waited = 0;
+    for (int i = 0; i < numCores; ++i) {
+        const Bus &bus = sim.getCoreBus(i);
+        uint64_t grants = bus.getGrants(i);
+        double meanWait = (grants > 0) ? static_cast<double>(bus.getTotalWait(i)) / grants : 0.0;
+        std::cout << "Core " << i << ": " << grants << " grants, mean wait "
+                  << std::fixed << std::setprecision(2) << meanWait << " cycles, max wait "
+                  << bus.getMaxWait(i) << " cycles\n";
+        if (grants > 0) {
+            sum += meanWait;
+            sumSquares += meanWait * meanWait;
+            waited++;
+        }
+    }
+    double fairness = (sumSquares > 0.0) ? (sum * sum) / (waited * sumSquares) : 1.0;
+    std::cout << "Wait Fairness (Jain): " << std::setprecision(4) << fairness << "\n\n";
+}
+
+// Lock rows printed, busiest first.
+static const size_t MAX_LOCKS_SHOWN = 16;
+
+// Function to print atomics, fences and per-lock contention.
+void printLockStatistics(const std::vector<Processor*>& processors, int blockSize) {
+    struct LockRow {
+        uint32_t block;
+        LockCounters total;
+        int cores;
+    };
+    std::map<uint32_t, LockRow> merged;
+    for (size_t i = 0; i < processors.size(); ++i) {
+        const Processor *proc = processors[i];
+        std::cout << "Core " << i << " Synchronization Statistics:\n";
+        std::cout << "Atomics: " << proc->getAtomics() << "\n";
+        std::cout << "Fences: " << proc->getFences() << "\n";
+        std::cout << "Fence Stall Cycles: " << proc->getFenceStallCycles() << "\n\n";
+        for (const auto &entry : proc->getLocks()) {
+            LockRow &row = merged.emplace(entry.first, LockRow{entry.first, LockCounters(), 0}).first->second;
+            row.total.atomics += entry.second.atomics;
+            row.total.contendedAtomics += entry.second.contendedAtomics;
+            row.total.atomicCycles += entry.second.atomicCycles;
+            row.total.spinReads += entry.second.spinReads;
+            row.total.spinMisses += entry.second.spinMisses;
+            row.cores++;
+        }
+    }
+
+    std::vector<LockRow> rows;
+    for (const auto &entry : merged) {
+        rows.push_back(entry.second);
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const LockRow &a, const LockRow &b) {
+        return a.total.atomics > b.total.atomics;
+    });
+    std::cout << "Lock Statistics:\n";
+    std::cout << "Lock Addresses: " << rows.size() << "\n";
+    for (size_t i = 0; i < rows.size() && i < MAX_LOCKS_SHOWN; ++i) {
+        const LockCounters &t = rows[i].total;
+        std::cout << "Lock 0x" << std::hex << rows[i].block << std::dec << ": "
+                  << t.atomics << " atomics from " << rows[i].cores << " cores, "
+                  << t.contendedAtomics << " contended (" << std::fixed << std::setprecision(2)
+                  << (t.atomics > 0 ? 100.0 * t.contendedAtomics / t.atomics : 0.0) << "%), mean latency "
+                  << (t.atomics > 0 ? static_cast<double>(t.atomicCycles) / t.atomics : 0.0) << " cycles, "
+                  << t.spinReads << " spin reads, " << t.spinMisses << " spin misses ("
+                  << t.spinMisses * blockSize << " bytes)\n";
+    }
+    if (rows.size() > MAX_LOCKS_SHOWN) {
+        std::cout << "(" << rows.size() - MAX_LOCKS_SHOWN << " quieter locks not shown)\n";
+    }
+    std::cout << "\n";
+}
+
+// Function to print intra- vs inter-cluster traffic and latency.
+void printClusterStatistics(const ClusteredBus &clustered) {
+    const ClusterInterconnect &net = clustered.getInterconnect();
+    uint64_t local = net.getLocalFills();
+    uint64_t remote = net.getRemoteFills();
+    double localLatency = (local > 0) ? static_cast<double>(net.getLocalFillLatency()) / local : 0.0;
+    double remoteLatency = (remote > 0) ? static_cast<double>(net.getRemoteFillLatency()) / remote : 0.0;
+    std::cout << "Cluster Statistics:\n";
+    std::cout << "Intra-Cluster Fills: " << local << "\n";
+    std::cout << "Intra-Cluster Average Fill Latency (Cycles): " << std::fixed << std::setprecision(2)
+              << localLatency << "\n";
+    std::cout << "Intra-Cluster Data Traffic (Bytes): " << net.getLocalBytes() << "\n";
+    std::cout << "Inter-Cluster Fills: " << remote << "\n";
+    std::cout << "Inter-Cluster Average Fill Latency (Cycles): " << remoteLatency << "\n";
+    std::cout << "Fills from Another Cluster's Cache: " << net.getRemoteCacheFills() << "\n";
+    std::cout << "Inter-Cluster Upgrades: " << net.getRemoteUpgrades() << "\n";
+    std::cout << "Inter-Cluster Write-Backs: " << net.getRemoteWritebacks() << "\n";
+    std::cout << "Interconnect Messages: " << net.getMessages() << "\n";
+    std::cout << "Inter-Cluster Traffic (Bytes): " << net.getRemoteBytes() << "\n";
+    std::cout << "Port Contention Cycles: " << net.getContentionCycles() << "\n\n";
+}
+
+// Function to print directory and on-chip network statistics.
+void printDirectoryStatistics(const Directory &dir) {
+    const Mesh &mesh = dir.getMesh();
+    uint64_t requests = dir.getRequests();
+    double avgLatency = (requests > 0) ? static_cast<double>(dir.getTotalRequestLatency()) / requests : 0.0;
+    double avgMessage = (mesh.getMessages() > 0)
+                            ? static_cast<double>(mesh.getTotalLatency()) / mesh.getMessages()
+                            : 0.0;
+    std::cout << "Directory Statistics:\n";
+    std::cout << "Miss Requests: " << requests << "\n";
+    std::cout << "Average Miss Latency (Cycles): " << std::fixed << std::setprecision(2) << avgLatency << "\n";
+    std::cout << "Upgrades: " << dir.getUpgrades() << "\n";
+    std::cout << "Forwarded to Owner: " << dir.getForwards() << "\n";
+    std::cout << "Stale Owner Forwards: " << dir.getStaleForwards() << "\n";
+    std::cout << "Invalidations Sent: " << dir.getInvalidations() << "\n";
+    if (dir.getConfig().pointers > 0) {
+        std::cout << "Broadcast Invalidations (Pointer Overflow): " << dir.getBroadcasts() << "\n";
+    }
+    std::cout << "Write-Back Messages: " << dir.getWritebacks() << "\n";
+    std::cout << "Network Messages: " << mesh.getMessages() << "\n";
+    std::cout << "Network Traffic (Bytes): " << mesh.getFlits() * dir.getConfig().flitBytes << "\n";
+    std::cout << "Flit-Hops: " << mesh.getFlitHops() << "\n";
+    std::cout << "Average Message Latency (Cycles): " << avgMessage << "\n";
+    std::cout << "Link Contention Cycles: " << mesh.getContentionCycles() << "\n\n";
+}
+
 // Function to print overall bus summary.
 void printBusSummary(Bus &bus, const std::vector<Cache*>& caches) {
-    int totalTraffic = bus.updateBusTrafficBytes(caches); // Updates and returns total bus traffic.
+    uint64_t totalTraffic = bus.updateBusTrafficBytes(caches); // Updates and returns total bus traffic.
     std::cout << "Overall Bus Summary:\n";
     std::cout << "Total Bus Transactions: " << bus.getTotalBusTransactions() << "\n";
     std::cout << "Total Bus Traffic (Bytes): " << totalTraffic << "\n";
+    if (bus.getPrefetchTransactions() > 0) {
+        std::cout << "Prefetch Bus Transactions: " << bus.getPrefetchTransactions() << "\n";
+        std::cout << "Prefetches Preempted by Demand: " << bus.getPreemptedPrefetches() << "\n";
+    }
+    if (bus.getAbsorbedWritebacks() > 0 || bus.getBlockingWritebacks() > 0) {
+        std::cout << "Write-Backs Absorbed by Buffer: " << bus.getAbsorbedWritebacks() << "\n";
+        std::cout << "Write-Backs Holding the Bus (Buffer Full): " << bus.getBlockingWritebacks() << "\n";
+        std::cout << "Misses Served from Write-Back Buffer: " << bus.getWritebackBufferHits() << "\n";
+        std::cout << "Peak Write-Back Buffer Occupancy: " << bus.getPeakWritebackBuffer() << "\n";
+    }
 }
 
-int main(int argc, char *argv[]) {
-    // Parse command-line arguments.
-    SimulationConfig config = parseArguments(argc, argv);
+// Longest per-core execution time: the figure the sweep compares.
+static uint64_t maxCoreCycles(const Simulator &sim) {
+    uint64_t maxCycles = 0;
+    for (auto proc : sim.getProcessors()) {
+        uint64_t cycles = proc->getTotalCycles() - proc->getIdleCycles();
+        if (cycles > maxCycles) {
+            maxCycles = cycles;
+        }
+    }
+    return maxCycles;
+}
 
-    const int numCores = 4; // Quad-core simulation.
-    std::vector<Processor*> processors;
-    std::vector<Cache*> caches;
+// Reruns the workload serially and at each swept quantum, and reports how
+// much faster the parallel runs are on the host. Their cycle counts are
+// printed too, as a check that they match the serial loop.
+void printQuantumSweep(const SimulationConfig &config) {
+    auto timeRun = [&](int quantum, uint64_t &maxCycles, uint64_t &clock) {
+        Simulator sim(config);
+        auto start = std::chrono::steady_clock::now();
+        if (quantum > 0) {
+            sim.runParallel(quantum);
+        } else {
+            sim.run();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        maxCycles = maxCoreCycles(sim);
+        clock = sim.getGlobalClock();
+        return seconds;
+    };
 
-    // Create a Bus instance.
-    Bus bus;
+    uint64_t serialMax = 0, serialClock = 0;
+    double serialSeconds = timeRun(0, serialMax, serialClock);
 
-    // Create a separate cache and processor for each core.
-    // IMPORTANT: When constructing caches, pass the processor's id.
-    for (int i = 0; i < numCores; ++i) {
-        // Construct trace file name (e.g., "app1_proc0.trace").
+    std::cout << "\nParallel Quantum Sweep:\n";
+    std::cout << "Serial: " << std::fixed << std::setprecision(3) << serialSeconds << " s, "
+              << "max core cycles " << serialMax << ", global clock " << serialClock << "\n";
+    for (int quantum : config.quantumSweep) {
+        uint64_t maxCycles = 0, clock = 0;
+        double seconds = timeRun(quantum, maxCycles, clock);
+        double error = (serialMax > 0)
+                           ? 100.0 * (static_cast<double>(maxCycles) - serialMax) / serialMax
+                           : 0.0;
+        std::cout << "Quantum " << quantum << ": " << std::setprecision(3) << seconds << " s, "
+                  << "speedup " << std::setprecision(2) << (seconds > 0.0 ? serialSeconds / seconds : 0.0) << "x, "
+                  << "max core cycles " << maxCycles << " (" << std::showpos << error << std::noshowpos << "%), "
+                  << "global clock " << clock << "\n";
+    }
+}
+
+// Per-core counters, read before and after a SimPoint slice.
+struct CoreCounters {
+    static const int count = 10;
+    uint64_t values[count];
+};
+
+static const char *coreCounterNames[CoreCounters::count] = {
+    "Total Instructions", "Total Reads", "Total Writes", "Total Execution Cycles", "Idle Cycles",
+    "Cache Misses", "Cache Evictions", "Writebacks", "Bus Invalidations", "Data Traffic (Bytes)"};
+
+static std::vector<CoreCounters> readCoreCounters(const Simulator &sim) {
+    std::vector<CoreCounters> counters;
+    for (size_t i = 0; i < sim.getProcessors().size(); ++i) {
+        const Processor *proc = sim.getProcessors()[i];
+        const Cache *cache = sim.getCaches()[i];
+        counters.push_back({{proc->getInstructionsExecuted(), proc->getTotalReads(), proc->getTotalWrites(),
+                             proc->getTotalCycles() - proc->getIdleCycles(), proc->getIdleCycles(),
+                             cache->getCacheMisses(), cache->getEvictions(), cache->getWritebacks(),
+                             cache->getBusInvalidations(), cache->getDataTrafficBytes()}});
+    }
+    return counters;
+}
+
+// Simulates each SimPoint slice on a fresh system, after running the
+// preceding warm-up instructions on it, and prints whole-run estimates:
+// every statistic is the weighted mean over the slices, scaled by the number
+// of intervals.
+void runSimPoints(const SimulationConfig &config, const SimPointSet &set) {
+    std::vector<std::shared_ptr<const std::vector<Instruction>>> traces;
+    uint64_t totalInstructions = 0;
+    for (int i = 0; i < config.numCores; ++i) {
         std::string traceFile = config.tracePrefix + "_proc" + std::to_string(i) + ".trace";
-        Cache* cache = new Cache(config.s, config.E, config.b, i, &bus);
-        caches.push_back(cache);
-        Processor* proc = new Processor(i, traceFile, cache, &bus);
-        processors.push_back(proc);
+        traces.push_back(std::make_shared<const std::vector<Instruction>>(TraceParser::parseTraceFile(traceFile)));
+        totalInstructions += traces.back()->size();
     }
+    uint64_t length = set.intervalLength;
+    uint64_t warmup = (config.simpointWarmup == UINT64_MAX) ? length : config.simpointWarmup;
+    auto slices = [&](uint64_t begin, uint64_t end) {
+        std::vector<InstructionSource*> sources;
+        for (auto &trace : traces) {
+            sources.push_back(new SliceSource(trace, begin, end));
+        }
+        return sources;
+    };
 
-    // Global clock simulation loop.
-    int globalClock = 0;
-    bool allFinished = false;
-    while (!allFinished) {
-#ifdef DEBUG
-        debug_print_caches(caches, globalClock);
-#endif
+    std::vector<std::vector<double>> estimate(config.numCores, std::vector<double>(CoreCounters::count, 0.0));
+    double busTransactions = 0.0, busTraffic = 0.0;
+    uint64_t simulated = 0;
+    for (const SimPoint &point : set.points) {
+        uint64_t start = point.interval * length;
+        uint64_t warmStart = (start > warmup) ? start - warmup : 0;
+        Simulator sim(config, slices(warmStart, start));
+        if (warmStart < start) {
+            sim.run();
+        }
+        std::vector<CoreCounters> before = readCoreCounters(sim);
+        uint64_t transactionsBefore = sim.getBus().getTotalBusTransactions();
+        uint64_t trafficBefore = sim.getBus().updateBusTrafficBytes(sim.getCaches());
 
-        allFinished = true;
-        // Let each processor execute one cycle.
-        // if(globalClock % 100000000 == 0) {
-        //     bus.printBusinfo();
-        // }
-        // Resolve any bus transactions at the end of the cycle.
-        bus.resolveTransactions(caches);
-        for (int i = 0; i < numCores; ++i) {
-            if (!processors[i]->isFinished() || bus.hasPendingtransaction()) {
-                processors[i]->executeCycle();
-                allFinished = false;
+        sim.setSources(slices(start, start + length));
+        if (config.parallelQuantum > 0) {
+            sim.runParallel(config.parallelQuantum);
+        } else {
+            sim.run();
+        }
+        std::vector<CoreCounters> after = readCoreCounters(sim);
+        double scale = point.weight * set.numIntervals;
+        for (int i = 0; i < config.numCores; ++i) {
+            for (int k = 0; k < CoreCounters::count; ++k) {
+                estimate[i][k] += scale * (after[i].values[k] - before[i].values[k]);
             }
-            // std :: cout << "Pending Bus Wr cycles ->" << bus.getPendingBusWrCycles() << "\n";
-            if(globalClock % 100000000 == 0) {
-                // std::cout << "Global Clock: " << globalClock << ", Processor " << i << " executed the instruction ->. " << processors[i]->getInstructionsExecuted() << "\n";
-                
-                
-                //print cache info
-                // caches[i]->printCacheInfo();
+            simulated += after[i].values[0] - before[i].values[0];
+        }
+        busTransactions += scale * (sim.getBus().getTotalBusTransactions() - transactionsBefore);
+        busTraffic += scale * (sim.getBus().updateBusTrafficBytes(sim.getCaches()) - trafficBefore);
+    }
+
+    std::cout << "\nSimPoint Estimate:\n";
+    std::cout << "Slices: " << set.points.size() << " of " << set.numIntervals << " intervals ("
+              << length << " instructions per core), warm-up " << warmup << " instructions\n";
+    std::cout << "Simulated Instructions: " << simulated << " of " << totalInstructions << " ("
+              << std::fixed << std::setprecision(2)
+              << (totalInstructions > 0 ? 100.0 * simulated / totalInstructions : 0.0) << "%)\n\n";
+    for (int i = 0; i < config.numCores; ++i) {
+        std::cout << "Core " << i << " Estimated Statistics:\n";
+        for (int k = 0; k < CoreCounters::count; ++k) {
+            std::cout << coreCounterNames[k] << ": " << std::setprecision(0) << estimate[i][k] << "\n";
+            if (k == 5) {
+                double accesses = estimate[i][1] + estimate[i][2];
+                std::cout << "Cache Miss Rate: " << std::setprecision(2)
+                          << (accesses > 0.0 ? 100.0 * estimate[i][5] / accesses : 0.0) << "%\n";
             }
         }
-        
+        std::cout << "\n";
+    }
+    std::cout << "Estimated Bus Summary:\n";
+    std::cout << "Total Bus Transactions: " << std::setprecision(0) << busTransactions << "\n";
+    std::cout << "Total Bus Traffic (Bytes): " << busTraffic << "\n";
+}
+
+// Runs and prints the fast estimate (--estimate).
+void runEstimate(const SimulationConfig &config) {
+    auto start = std::chrono::steady_clock::now();
+    Estimator estimator(config);
+    estimator.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-        globalClock++;
+    const std::vector<EstimateCoreStats> &cores = estimator.getCores();
+    std::cout << std::fixed;
+    for (size_t i = 0; i < cores.size(); ++i) {
+        const EstimateCoreStats &c = cores[i];
+        std::cout << "Core " << i << " Estimated Statistics:\n";
+        std::cout << "Total Instructions: " << c.instructions << "\n";
+        std::cout << "Total Reads: " << c.reads << "\n";
+        std::cout << "Total Writes: " << c.writes << "\n";
+        std::cout << "Total Execution Cycles: " << std::setprecision(0) << c.executionCycles() << "\n";
+        std::cout << "Idle Cycles: " << c.busWait << "\n";
+        std::cout << "Cache Hits: " << c.hits << "\n";
+        std::cout << "Cache Misses: " << c.misses() << "\n";
+        std::cout << "Cache Miss Rate: " << std::setprecision(2)
+                  << (c.instructions > 0 ? 100.0 * c.misses() / c.instructions : 0.0) << "%\n";
+        std::cout << "Misses Served by Memory: " << c.memoryFills << "\n";
+        std::cout << "Misses Served Cache-to-Cache: " << c.cacheToCacheFills << "\n";
+        std::cout << "Upgrades: " << c.upgrades << "\n";
+        std::cout << "Cache Evictions: " << c.evictions << "\n";
+        std::cout << "Writebacks: " << c.writebacks << "\n";
+        std::cout << "Bus Invalidations: " << c.invalidations << "\n";
+        std::cout << "Data Traffic (Bytes): " << c.dataTrafficBytes << "\n\n";
     }
+    std::cout << "Estimated Bus Summary:\n";
+    std::cout << "Total Bus Transactions: " << estimator.getBusTransactions() << "\n";
+    std::cout << "Total Bus Traffic (Bytes): " << estimator.getBusTrafficBytes() << "\n";
+    std::cout << "Bus Utilization: " << std::setprecision(2) << 100.0 * estimator.getBusUtilization() << "%\n";
+    std::cout << "Estimated Cycles (Slowest Core): " << std::setprecision(0) << estimator.getEstimatedCycles() << "\n";
+    std::cout << "Queueing Model Iterations: " << estimator.getModelIterations() << "\n";
+    std::cout << "Host Time (s): " << std::setprecision(3) << seconds << "\n";
+}
 
-    // After simulation, update bus traffic bytes.
-    int totalBusTraffic = bus.updateBusTrafficBytes(caches);
+// Runs the configured simulation and prints its output.
+void simulate(const SimulationConfig &config) {
+
+    if (!config.simpointFile.empty()) {
+        SimPointSet set;
+        if (!readSimPoints(config.simpointFile, set)) {
+            exit(1);
+        }
+        int numSets = (1 << config.s);
+        std::cout << "\nSimulation Output:\n";
+        printSimulationParameters(config, numSets, (numSets * config.E * (1 << config.b)) / 1024);
+        runSimPoints(config, set);
+        return;
+    }
+
+    if (config.estimate) {
+        int numSets = (1 << config.s);
+        std::cout << "\nSimulation Output (Fast Estimate):\n";
+        printSimulationParameters(config, numSets, (numSets * config.E * (1 << config.b)) / 1024);
+        runEstimate(config);
+        return;
+    }
+
+    // Host-side profiling is only wired in when requested.
+    Profiler profiler;
+    Profiler *prof = config.profile ? &profiler : nullptr;
+
+    Simulator sim(config, prof);
+    std::unique_ptr<SnapshotWriter> snapshots;
+    if (config.snapshotInterval > 0) {
+        snapshots.reset(new SnapshotWriter(config.snapshotFile));
+        if (!snapshots->isOpen()) {
+            std::cerr << "Cannot open snapshot file " << config.snapshotFile << std::endl;
+            exit(1);
+        }
+        sim.setSnapshots(snapshots.get(), config.snapshotInterval);
+    }
+    std::unique_ptr<EventTracer> tracer;
+    if (!config.eventTraceFile.empty()) {
+        tracer.reset(new EventTracer(config.eventTraceFile, config.eventFilter));
+        if (!tracer->isOpen()) {
+            std::cerr << "Cannot open event trace " << config.eventTraceFile << std::endl;
+            exit(1);
+        }
+        EventTracer::active = tracer.get();
+    }
+    if (config.parallelQuantum > 0) {
+        sim.runParallel(config.parallelQuantum);
+    } else {
+        sim.run();
+    }
+    EventTracer::active = nullptr;
+    Bus &bus = sim.getBus();
+    const std::vector<Processor*> &processors = sim.getProcessors();
+    const std::vector<Cache*> &caches = sim.getCaches();
 
     // Derived parameters.
     int numSets = (1 << config.s);
@@ -185,15 +867,191 @@ int main(int argc, char *argv[]) {
     std::cout << "\nSimulation Output:\n";
     printSimulationParameters(config, numSets, cacheSizeKB);
     printCoreStatistics(processors, caches);
+    if (config.prefetcher != PrefetcherKind::None) {
+        printPrefetchStatistics(caches);
+    }
+    if (config.storeBufferEntries > 0) {
+        printStoreBufferStatistics(processors);
+    }
+    if (config.useTlb) {
+        printTlbStatistics(sim, config.numCores);
+    }
+    if (config.victimEntries > 0) {
+        printVictimCacheStatistics(caches);
+    }
+    if (sim.getL2()) {
+        printL2Statistics(*sim.getL2());
+    }
+    if (sim.getDram()) {
+        printDramStatistics(*sim.getDram());
+    }
+    if (sim.getDirectory()) {
+        printDirectoryStatistics(*sim.getDirectory());
+    }
+    if (sim.getClusteredBus()) {
+        printClusterStatistics(*sim.getClusteredBus());
+    }
+    if (config.reportBusWait) {
+        printBusWaitStatistics(sim, static_cast<int>(processors.size()));
+    }
+    bool hasSync = false;
+    for (const Processor *proc : processors) {
+        hasSync = hasSync || proc->getAtomics() > 0 || proc->getFences() > 0;
+    }
+    if (hasSync) {
+        printLockStatistics(processors, blockSize);
+    }
     printBusSummary(bus, caches);
+    if (tracer) {
+        std::cout << "\nEvent Trace:\n";
+        std::cout << "Events Recorded: " << tracer->getRecorded() << "\n";
+        std::cout << "Writer Stalls (Buffer Full): " << tracer->getProducerStalls() << "\n";
+        tracer.reset();
+    }
+    if (prof) {
+        prof->printReport(std::cout, sim.getGlobalClock());
+    }
+    if (!config.quantumSweep.empty()) {
+        printQuantumSweep(config);
+    }
     // std::cout << "Global Clock: " << globalClock << " cycles\n";
+}
+
+// Runs whose output is a pure function of the options and inputs; the rest
+// report host timing or write files that a replayed result would not.
+static bool isCacheable(const SimulationConfig &config) {
+    return !config.profile && !config.estimate && config.quantumSweep.empty() &&
+           config.snapshotInterval == 0 && config.eventTraceFile.empty();
+}
+
+// Adds every parsed option the output depends on, so the order and spelling
+// of the command line do not matter. Options that make a run uncacheable
+// (see isCacheable) and the result cache's own are left out.
+static void addConfigValues(const SimulationConfig &config, ResultKey &key) {
+    auto add = [&key](const char *name, auto value) {
+        std::ostringstream text;
+        text << std::hexfloat << value;
+        key.addValue(name, text.str());
+    };
+    // The run prints the trace prefix or workload spec, so they are part of
+    // the output even though the files enter by content alone.
+    if (config.useWorkload) {
+        const WorkloadConfig &w = config.workload;
+        key.addValue("workload", w.spec);
+        add("workload.kind", static_cast<int>(w.kind));
+        add("workload.count", w.count);
+        add("workload.footprint", w.footprint);
+        add("workload.stride", w.stride);
+        add("workload.share", w.share);
+        add("workload.write", w.writeRatio);
+        add("workload.alpha", w.zipfAlpha);
+        add("workload.gap", w.gap);
+        add("workload.atomic", w.atomic);
+        add("workload.seed", w.seed);
+    } else {
+        key.addValue("prefix", config.tracePrefix);
+    }
+    add("cores", config.numCores);
+    add("s", config.s);
+    add("E", config.E);
+    add("b", config.b);
+    add("predecode", config.predecode);
+    add("generic-cache", config.genericCache);
+    add("parallel", config.parallelQuantum);
+    add("prefetch", static_cast<int>(config.prefetcher));
+    add("prefetch-degree", config.prefetchDegree);
+    add("store-buffer", config.storeBufferEntries);
+    add("victim", config.victimEntries);
+    if (config.useL2) {
+        add("l2.s", config.l2s);
+        add("l2.E", config.l2E);
+        add("l2.b", config.l2b);
+        add("l2.latency", config.l2Latency);
+        add("l2.inclusive", config.l2Inclusive);
+    }
+    add("writeback-buffer", config.writebackBufferEntries);
+    add("arbitration", static_cast<int>(config.arbitration));
+    add("bus-wait", config.reportBusWait);
+    if (config.useDram) {
+        const DramConfig &d = config.dram;
+        add("dram.open", d.openPage);
+        add("dram.banks", d.banks);
+        add("dram.row", d.rowBytes);
+        add("dram.tRCD", d.tRCD);
+        add("dram.tCL", d.tCL);
+        add("dram.tRP", d.tRP);
+        add("dram.burst", d.burst);
+    }
+    if (config.useDirectory) {
+        const DirectoryConfig &d = config.directory;
+        add("directory.pointers", d.pointers);
+        add("directory.hop", d.hopLatency);
+        add("directory.flit", d.flitBytes);
+        add("directory.lookup", d.lookupLatency);
+    }
+    if (config.useClusters) {
+        const ClusterConfig &c = config.cluster;
+        add("clusters", c.clusters);
+        add("clusters.latency", c.linkLatency);
+        add("clusters.bandwidth", c.bytesPerCycle);
+        add("clusters.header", c.headerBytes);
+    }
+    if (config.useTlb) {
+        const TlbConfig &t = config.tlb;
+        add("tlb.mapping", static_cast<int>(t.mapping));
+        add("tlb.entries", t.entries);
+        add("tlb.ways", t.ways);
+        add("tlb.page", t.pageBits);
+        add("tlb.levels", t.levels);
+        add("tlb.miss", t.missPenalty);
+        add("tlb.seed", t.seed);
+    }
+    if (!config.simpointFile.empty()) {
+        add("simpoint-warmup", config.simpointWarmup);
+    }
+}
+
+// Keys a run by the simulator binary, its parsed options and the contents
+// of every file it reads. Returns false if the binary cannot be identified.
+static bool buildResultKey(const SimulationConfig &config, const char *argv0, ResultKey &key) {
+    if (!key.addFile("binary", "/proc/self/exe") && !key.addFile("binary", argv0)) {
+        return false;
+    }
+    addConfigValues(config, key);
+    if (!config.useWorkload) {
+        for (int i = 0; i < config.numCores; ++i) {
+            key.addFile("trace", config.tracePrefix + "_proc" + std::to_string(i) + ".trace");
+        }
+    }
+    if (!config.simpointFile.empty()) {
+        key.addFile("simpoints", config.simpointFile);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    // Parse command-line arguments.
+    SimulationConfig config = parseArguments(argc, argv);
+
+    ResultKey key;
+    if (config.resultCacheDir.empty() || !isCacheable(config) || !buildResultKey(config, argv[0], key)) {
+        simulate(config);
+        return 0;
+    }
 
-    // Clean up.
-    for (auto proc : processors) {
-        delete proc;
+    ResultCache cache(config.resultCacheDir);
+    std::string output;
+    if (!config.refreshResultCache && cache.lookup(key, output)) {
+        std::cout << output;
+        std::cerr << "Result cache hit: " << cache.entryPath(key) << std::endl;
+        return 0;
     }
-    for (auto cache : caches) {
-        delete cache;
+    {
+        OutputRecorder recorder(std::cout);
+        simulate(config);
+        std::cout.flush();
+        output = recorder.recorded();
     }
+    cache.store(key, output);
     return 0;
 }
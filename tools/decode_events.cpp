@@ -0,0 +1,126 @@
+// Decodes a binary event trace written by `L1simulate --event-trace` into
+// one text line per record:
+//     <cycle> P<core> <category> <event> 0x<address> <detail>
+//
+// Usage: decode_events <file> [category,...]
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "EventTrace.hpp"
+
+static const char *mesiName(uint32_t state)
+{
+    static const char *names[] = {"M", "E", "S", "I"};
+    return (state < 4) ? names[state] : "?";
+}
+
+static const char *busName(uint32_t type)
+{
+    static const char *names[] = {"BusRd", "BusRdX", "BusRdWITWr", "BusUpgr", "BusWr"};
+    return (type < 5) ? names[type] : "?";
+}
+
+static std::string detail(const TraceRecord &r)
+{
+    std::ostringstream out;
+    switch (static_cast<TraceEvent>(r.event))
+    {
+    case TraceEvent::CacheHit:
+    case TraceEvent::CacheMiss:
+    case TraceEvent::ProcRetire:
+    {
+        static const char *ops[] = {"read", "write", "atomic", "fence"};
+        out << (r.arg < 4 ? ops[r.arg] : "?");
+        break;
+    }
+    case TraceEvent::CacheFill:
+        out << "-> " << mesiName(r.arg & 0xff) << " delay=" << (r.arg >> 8);
+        break;
+    case TraceEvent::CacheEvict:
+        out << "was " << mesiName(r.arg);
+        break;
+    case TraceEvent::SnoopDowngrade:
+        out << mesiName(r.arg) << " -> S";
+        break;
+    case TraceEvent::SnoopInvalidate:
+        out << mesiName(r.arg) << " -> I";
+        break;
+    case TraceEvent::BusQueue:
+        out << busName(r.arg);
+        break;
+    case TraceEvent::BusGrant:
+        out << "delay=" << r.arg;
+        break;
+    default:
+        out << "arg=" << r.arg;
+    }
+    return out.str();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <event trace> [category,...]\n"
+                  << "       categories: cache snoop bus processor" << std::endl;
+        return 1;
+    }
+
+    unsigned categories = ~0u;
+    if (argc > 2)
+    {
+        categories = 0;
+        std::istringstream names(argv[2]);
+        std::string name;
+        while (std::getline(names, name, ','))
+        {
+            int i = 0;
+            while (i < static_cast<int>(TraceCategory::Count) &&
+                   name != traceCategoryName(static_cast<TraceCategory>(i)))
+                i++;
+            if (i == static_cast<int>(TraceCategory::Count))
+            {
+                std::cerr << "Unknown category '" << name << "'" << std::endl;
+                return 1;
+            }
+            categories |= 1u << i;
+        }
+    }
+
+    FILE *file = std::fopen(argv[1], "rb");
+    if (!file)
+    {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    TraceFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, "L1EVENT", 8) != 0 ||
+        header.recordBytes != sizeof(TraceRecord))
+    {
+        std::cerr << argv[1] << " is not an event trace from this build" << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+
+    TraceRecord records[4096];
+    size_t n;
+    while ((n = std::fread(records, sizeof(TraceRecord), 4096, file)) > 0)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            const TraceRecord &r = records[i];
+            if (!((categories >> r.category) & 1))
+                continue;
+            std::printf("%llu P%d %s %s 0x%08x %s\n",
+                        static_cast<unsigned long long>(r.cycle), r.core,
+                        traceCategoryName(static_cast<TraceCategory>(r.category)),
+                        traceEventName(static_cast<TraceEvent>(r.event)),
+                        r.address, detail(r).c_str());
+        }
+    }
+    std::fclose(file);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Picks representative slices of a multi-core trace set for
+// `L1simulate --simpoints`.
+//
+// Usage: simpoint -t <tracePrefix> [-b <b>] [--cores <n>] [--interval <instructions>]
+//                 [--max-k <k>] [--dims <d>] [--seed <n>] [-o <file>]
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "SimPoint.hpp"
+#include "TraceParser.hpp"
+
+int main(int argc, char *argv[])
+{
+    SimPointConfig config;
+    std::string prefix, output;
+    int numCores = 4;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            prefix = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            config.blockBits = std::stoi(argv[++i]);
+        else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc)
+            numCores = std::stoi(argv[++i]);
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+            config.intervalLength = std::stoull(argv[++i]);
+        else if (strcmp(argv[i], "--max-k") == 0 && i + 1 < argc)
+            config.maxClusters = std::stoi(argv[++i]);
+        else if (strcmp(argv[i], "--dims") == 0 && i + 1 < argc)
+            config.dimensions = std::stoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            config.seed = std::stoull(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " -t <tracePrefix> [-b <b>] [--cores <n>] [--interval <instructions>]\n"
+                      << "       [--max-k <k>] [--dims <d>] [--seed <n>] [-o <file>]" << std::endl;
+            return 1;
+        }
+    }
+    if (prefix.empty() || numCores < 1 || config.intervalLength == 0 ||
+        config.maxClusters < 1 || config.dimensions < 1)
+    {
+        std::cerr << "Need -t <tracePrefix> and positive --cores, --interval, --max-k and --dims" << std::endl;
+        return 1;
+    }
+    if (output.empty())
+        output = prefix + ".simpoints";
+
+    std::vector<std::vector<Instruction>> traces;
+    for (int i = 0; i < numCores; ++i)
+        traces.push_back(TraceParser::parseTraceFile(prefix + "_proc" + std::to_string(i) + ".trace"));
+
+    SimPointSet set = pickSimPoints(intervalSignatures(traces, config), config);
+    if (set.points.empty())
+    {
+        std::cerr << "The traces are empty" << std::endl;
+        return 1;
+    }
+    if (!writeSimPoints(output, set))
+        return 1;
+
+    std::cout << "Intervals: " << set.numIntervals << " of " << config.intervalLength << " instructions per core\n";
+    std::cout << "Clusters: " << set.points.size() << "\n";
+    for (const SimPoint &p : set.points)
+        std::cout << "Interval " << p.interval << ": weight " << std::fixed << std::setprecision(4) << p.weight << "\n";
+    std::cout << "Simulated Fraction: " << std::setprecision(2)
+              << 100.0 * set.points.size() / set.numIntervals << "%\n";
+    std::cout << "Wrote " << output << "\n";
+    return 0;
+}